@@ -0,0 +1,379 @@
+/*****************************************************************************
+ * click_logic.c : Mouse click decision logic, independent of VLC
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "click_logic.h"
+
+#include <stddef.h>
+
+enum click_event {
+    // the pause/play mouse button was clicked
+    CLICK_EVENT_CLICK,
+    // the double click delay has passed
+    CLICK_EVENT_TIMEOUT,
+    CLICK_EVENTS
+};
+
+// how the pause/play mouse button treats double clicks
+enum click_mode {
+    // pause/play on every click, leave double clicks to VLC
+    CLICK_MODE_IMMEDIATE,
+    // pause/play on every click, detect double clicks with our own delay
+    CLICK_MODE_DOUBLE_CLICK_DELAY,
+    // pause/play only once it's clear that a click is not a double click
+    CLICK_MODE_IGNORE_DOUBLE_CLICK,
+    // pause/play on the first click, undo it if it's a double click
+    CLICK_MODE_SPECULATIVE,
+    CLICK_MODES
+};
+
+struct click_transition {
+    uint8_t next;
+    uint8_t actions;
+};
+
+static const struct click_transition transitions[CLICK_MODES][CLICK_STATES][CLICK_EVENTS] = {
+    [CLICK_MODE_IMMEDIATE] = {
+        [CLICK_STATE_IDLE] = {
+            [CLICK_EVENT_CLICK] = {CLICK_STATE_IDLE, CLICK_ACTION_PAUSE_PLAY},
+            [CLICK_EVENT_TIMEOUT] = {CLICK_STATE_IDLE, 0},
+        },
+        // the settings have changed while a click was pending
+        [CLICK_STATE_PENDING] = {
+            [CLICK_EVENT_CLICK] = {CLICK_STATE_IDLE, CLICK_ACTION_PAUSE_PLAY | CLICK_ACTION_TIMER_CANCEL},
+            [CLICK_EVENT_TIMEOUT] = {CLICK_STATE_IDLE, 0},
+        },
+    },
+    [CLICK_MODE_DOUBLE_CLICK_DELAY] = {
+        [CLICK_STATE_IDLE] = {
+            [CLICK_EVENT_CLICK] = {CLICK_STATE_PENDING, CLICK_ACTION_PAUSE_PLAY | CLICK_ACTION_TIMER_START},
+            [CLICK_EVENT_TIMEOUT] = {CLICK_STATE_IDLE, 0},
+        },
+        [CLICK_STATE_PENDING] = {
+            [CLICK_EVENT_CLICK] = {CLICK_STATE_IDLE, CLICK_ACTION_PAUSE_PLAY | CLICK_ACTION_TIMER_CANCEL |
+                                                     CLICK_ACTION_SET_FULLSCREEN},
+            [CLICK_EVENT_TIMEOUT] = {CLICK_STATE_IDLE, 0},
+        },
+    },
+    [CLICK_MODE_IGNORE_DOUBLE_CLICK] = {
+        [CLICK_STATE_IDLE] = {
+            [CLICK_EVENT_CLICK] = {CLICK_STATE_PENDING, CLICK_ACTION_TIMER_START},
+            [CLICK_EVENT_TIMEOUT] = {CLICK_STATE_IDLE, 0},
+        },
+        [CLICK_STATE_PENDING] = {
+            [CLICK_EVENT_CLICK] = {CLICK_STATE_IDLE, CLICK_ACTION_TIMER_CANCEL | CLICK_ACTION_SET_FULLSCREEN},
+            [CLICK_EVENT_TIMEOUT] = {CLICK_STATE_IDLE, CLICK_ACTION_PAUSE_PLAY},
+        },
+    },
+    [CLICK_MODE_SPECULATIVE] = {
+        [CLICK_STATE_IDLE] = {
+            [CLICK_EVENT_CLICK] = {CLICK_STATE_PENDING, CLICK_ACTION_PAUSE_PLAY | CLICK_ACTION_TIMER_START},
+            [CLICK_EVENT_TIMEOUT] = {CLICK_STATE_IDLE, 0},
+        },
+        [CLICK_STATE_PENDING] = {
+            [CLICK_EVENT_CLICK] = {CLICK_STATE_IDLE, CLICK_ACTION_ROLLBACK | CLICK_ACTION_TIMER_CANCEL |
+                                                     CLICK_ACTION_SET_FULLSCREEN},
+            // the speculation was right, nothing left to do
+            [CLICK_EVENT_TIMEOUT] = {CLICK_STATE_IDLE, 0},
+        },
+    },
+};
+
+void click_quantile_init(struct click_quantile *q, double p)
+{
+    q->p = p;
+    q->count = 0;
+    for (int i = 0; i < 5; i ++) {
+        q->q[i] = 0;
+        q->n[i] = i;
+    }
+    q->np[0] = 0;
+    q->np[1] = 2*p;
+    q->np[2] = 4*p;
+    q->np[3] = 2 + 2*p;
+    q->np[4] = 4;
+}
+
+void click_quantile_add(struct click_quantile *q, double x)
+{
+    // the first five samples become the markers
+    if (q->count < 5) {
+        int i = q->count++;
+        for (; i > 0 && q->q[i-1] > x; i --) {
+            q->q[i] = q->q[i-1];
+        }
+        q->q[i] = x;
+        return;
+    }
+    q->count ++;
+
+    // find the cell the sample falls into, extending the extremes
+    int k;
+    if (x < q->q[0]) {
+        q->q[0] = x;
+        k = 0;
+    } else if (x >= q->q[4]) {
+        q->q[4] = x;
+        k = 3;
+    } else {
+        for (k = 0; k < 3 && x >= q->q[k+1]; k ++);
+    }
+    for (int i = k + 1; i < 5; i ++) {
+        q->n[i] += 1;
+    }
+    const double dn[5] = {0, q->p/2, q->p, (1 + q->p)/2, 1};
+    for (int i = 0; i < 5; i ++) {
+        q->np[i] += dn[i];
+    }
+
+    // move the middle markers towards their desired positions
+    for (int i = 1; i <= 3; i ++) {
+        const double d = q->np[i] - q->n[i];
+        if ((d >= 1 && q->n[i+1] - q->n[i] > 1) || (d <= -1 && q->n[i-1] - q->n[i] < -1)) {
+            const int s = d >= 0 ? 1 : -1;
+            // piecewise-parabolic prediction, falling back to the linear one
+            // if it would break the marker order
+            const double qp = q->q[i] + s / (q->n[i+1] - q->n[i-1]) *
+                              ((q->n[i] - q->n[i-1] + s) * (q->q[i+1] - q->q[i]) / (q->n[i+1] - q->n[i]) +
+                               (q->n[i+1] - q->n[i] - s) * (q->q[i] - q->q[i-1]) / (q->n[i] - q->n[i-1]));
+            if (q->q[i-1] < qp && qp < q->q[i+1]) {
+                q->q[i] = qp;
+            } else {
+                q->q[i] += s * (q->q[i+s] - q->q[i]) / (q->n[i+s] - q->n[i]);
+            }
+            q->n[i] += s;
+        }
+    }
+}
+
+double click_quantile_get(const struct click_quantile *q)
+{
+    if (q->count == 0) {
+        return 0;
+    }
+    if (q->count < 5) {
+        // nearest rank of the few sorted samples
+        int i = (int) (q->p * q->count);
+        return q->q[i < (int) q->count ? i : (int) q->count - 1];
+    }
+    return q->q[2];
+}
+
+// we can tell double clicks apart on our own only for the left button, as
+// that's the only one VLC does double clicks for
+static enum click_mode get_mode(const struct click_config *cfg)
+{
+    if (cfg->mouse_button != CLICK_BUTTON_LEFT) {
+        return CLICK_MODE_IMMEDIATE;
+    }
+    if (cfg->ignore_double_click) {
+        return cfg->speculative ? CLICK_MODE_SPECULATIVE : CLICK_MODE_IGNORE_DOUBLE_CLICK;
+    }
+    if (cfg->enable_double_click_delay) {
+        return CLICK_MODE_DOUBLE_CLICK_DELAY;
+    }
+    return CLICK_MODE_IMMEDIATE;
+}
+
+static bool has_pressed(const struct click_mouse *p_old, const struct click_mouse *p_new, int button)
+{
+    if (button < 0) {
+        return false;
+    }
+    const int mask = 1 << button;
+    return !(p_old->pressed & mask) && (p_new->pressed & mask);
+}
+
+static bool is_pressed(const struct click_mouse *p_mouse, int button)
+{
+    return p_mouse->pressed & (1 << button);
+}
+
+static unsigned transition(struct click_machine *m, const struct click_config *cfg,
+                           enum click_event event, int64_t now)
+{
+    const struct click_transition *t = &transitions[get_mode(cfg)][m->state][event];
+    if (t->actions & CLICK_ACTION_TIMER_START) {
+        m->click_time = now;
+        m->deadline = now + click_machine_delay(m, cfg)*1000;
+    }
+    m->state = t->next;
+    return t->actions;
+}
+
+void click_machine_init(struct click_machine *m, const struct click_clock *clock)
+{
+    m->clock = clock;
+    m->state = CLICK_STATE_IDLE;
+    m->click_time = 0;
+    m->deadline = 0;
+    click_quantile_init(&m->gaps, CLICK_ADAPTIVE_QUANTILE);
+    m->last_click_time = 0;
+    m->learned_delay = 0;
+}
+
+// Records the gap since the previous click if it's short enough to be a
+// double click. Gaps are taken against the configured window rather than the
+// adaptive one, so that the estimate can grow back if it has become too short.
+static void record_gap(struct click_machine *m, const struct click_config *cfg, int64_t now)
+{
+    if (m->last_click_time && now - m->last_click_time <= cfg->double_click_delay*1000) {
+        click_quantile_add(&m->gaps, (double) (now - m->last_click_time));
+    }
+    m->last_click_time = now;
+}
+
+void click_machine_cancel(struct click_machine *m)
+{
+    m->state = CLICK_STATE_IDLE;
+    m->click_time = 0;
+    m->deadline = 0;
+    // so that the next click isn't taken for the second one of a double click
+    m->last_click_time = 0;
+}
+
+int64_t click_machine_delay(const struct click_machine *m, const struct click_config *cfg)
+{
+    if (!cfg->adaptive_double_click_delay) {
+        return cfg->double_click_delay;
+    }
+
+    int64_t delay;
+    if (click_machine_has_learned(m)) {
+        delay = (int64_t) (click_quantile_get(&m->gaps) / 1000) + CLICK_ADAPTIVE_MARGIN;
+    } else if (m->learned_delay > 0) {
+        delay = m->learned_delay;
+    } else {
+        return cfg->double_click_delay;
+    }
+    if (delay < CLICK_ADAPTIVE_MIN_DELAY) {
+        delay = CLICK_ADAPTIVE_MIN_DELAY;
+    }
+    if (delay > cfg->double_click_delay) {
+        delay = cfg->double_click_delay;
+    }
+    return delay;
+}
+
+bool click_machine_has_learned(const struct click_machine *m)
+{
+    return m->gaps.count >= CLICK_ADAPTIVE_MIN_SAMPLES;
+}
+
+static int button_mask(int button)
+{
+    return button < 0 ? 0 : 1 << button;
+}
+
+void click_interest_init(struct click_interest *p_interest, const struct click_config *cfg)
+{
+    // a double click always goes through the machine
+    p_interest->press = button_mask(cfg->mouse_button) | button_mask(cfg->fs_mouse_button) |
+                        button_mask(cfg->context_menu_mouse_button);
+    p_interest->release = 0;
+    p_interest->hold = cfg->disable_context_menu_toggle ? button_mask(CLICK_BUTTON_RIGHT) : 0;
+}
+
+unsigned click_machine_mouse(struct click_machine *m, const struct click_config *cfg,
+                             const struct click_mouse *p_old, const struct click_mouse *p_new,
+                             struct click_mouse *p_out)
+{
+    unsigned actions = 0;
+    bool press_left = false;
+
+    *p_out = *p_new;
+
+    if (click_logic_is_idle(p_new)) {
+        return actions;
+    }
+
+    // manually control double click to fullscreen
+    if (get_mode(cfg) != CLICK_MODE_IMMEDIATE) {
+        actions |= CLICK_ACTION_CLEAR_DOUBLE_CLICK;
+    }
+
+    // react only on the configured mouse button click
+    if (has_pressed(p_old, p_new, cfg->mouse_button) ||
+            // treat the double click as the left mouse button click
+            (cfg->double_click_is_click && p_new->double_click && cfg->mouse_button == CLICK_BUTTON_LEFT)) {
+        const int64_t now = m->clock->now(m->clock->opaque);
+        if (cfg->adaptive_double_click_delay) {
+            record_gap(m, cfg, now);
+        }
+        actions |= transition(m, cfg, CLICK_EVENT_CLICK, now);
+    }
+
+    // prevent fullscreen from toggling on double click
+    if (cfg->disable_fs_toggle) {
+        actions &= ~CLICK_ACTION_SET_FULLSCREEN;
+        actions |= CLICK_ACTION_CLEAR_DOUBLE_CLICK;
+    }
+
+    // toggle fullscreen on specified mouse click
+    if (has_pressed(p_old, p_new, cfg->fs_mouse_button)) {
+        actions |= CLICK_ACTION_SET_FULLSCREEN;
+        press_left = cfg->fs_toggle_presses_left;
+    }
+
+    // prevent the context menu from toggling on right click
+    if (cfg->disable_context_menu_toggle && is_pressed(p_new, CLICK_BUTTON_RIGHT)) {
+        actions |= CLICK_ACTION_SUPPRESS_CONTEXT_MENU;
+    }
+
+    // toggle context menu on specified mouse click
+    if (has_pressed(p_old, p_new, cfg->context_menu_mouse_button)) {
+        actions |= CLICK_ACTION_SET_CONTEXT_MENU;
+    }
+
+    // apply the actions to the mouse state, in this order
+    if (actions & CLICK_ACTION_CLEAR_DOUBLE_CLICK) {
+        p_out->double_click = false;
+    }
+    if (actions & CLICK_ACTION_SET_FULLSCREEN) {
+        if (press_left) {
+            p_out->pressed |= 1 << CLICK_BUTTON_LEFT;
+        }
+        p_out->double_click = true;
+    }
+    if (actions & CLICK_ACTION_SUPPRESS_CONTEXT_MENU) {
+        p_out->pressed = 0;
+    }
+    if (actions & CLICK_ACTION_SET_CONTEXT_MENU) {
+        p_out->pressed |= 1 << CLICK_BUTTON_RIGHT;
+    }
+
+    return actions;
+}
+
+unsigned click_machine_timeout(struct click_machine *m, const struct click_config *cfg)
+{
+    if (m->state != CLICK_STATE_PENDING) {
+        return 0;
+    }
+    const int64_t now = m->clock->now(m->clock->opaque);
+    if (now < m->deadline) {
+        // fired early, wait for the rest of it
+        return CLICK_ACTION_TIMER_START;
+    }
+    return transition(m, cfg, CLICK_EVENT_TIMEOUT, now);
+}
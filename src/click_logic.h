@@ -0,0 +1,216 @@
+/*****************************************************************************
+ * click_logic.h : Mouse click decision logic, independent of VLC
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CLICK_LOGIC_H
+#define CLICK_LOGIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The decisions the plugin makes on mouse events, kept free of any VLC
+// dependencies so that they can be run outside of VLC, e.g. to replay
+// recorded mouse traces.
+//
+// The single/double click handling is a small state machine driven by a
+// transition table. It doesn't run any timers itself, instead it tells the
+// caller when to start or cancel a timer for its deadline, and reads the time
+// from a clock the caller provides.
+
+// mouse buttons, numbered the same way VLC numbers them
+enum click_button {
+    CLICK_BUTTON_NONE = -1,
+    CLICK_BUTTON_LEFT,
+    CLICK_BUTTON_CENTER,
+    CLICK_BUTTON_RIGHT,
+    CLICK_BUTTON_WHEEL_UP,
+    CLICK_BUTTON_WHEEL_DOWN,
+    CLICK_BUTTON_WHEEL_LEFT,
+    CLICK_BUTTON_WHEEL_RIGHT,
+};
+
+struct click_config {
+    int mouse_button;
+    int fs_mouse_button;
+    int context_menu_mouse_button;
+    int64_t double_click_delay; // in milliseconds
+    bool enable_double_click_delay;
+    bool ignore_double_click;
+    // with ignore_double_click, pause/play right away and roll it back if it
+    // turns out to be a double click
+    bool speculative;
+    // shrink double_click_delay to the user's actual double click speed
+    bool adaptive_double_click_delay;
+    bool disable_fs_toggle;
+    bool disable_context_menu_toggle;
+    // VLC 2 and 3 report the second click of a double click only as a double
+    // click, without the button being pressed
+    bool double_click_is_click;
+    // VLC 4 needs the left button to be pressed for a double click to
+    // toggle fullscreen
+    bool fs_toggle_presses_left;
+};
+
+struct click_mouse {
+    int pressed; // bitmask of (1 << enum click_button)
+    bool double_click;
+};
+
+struct click_clock {
+    // monotonic time in microseconds
+    int64_t (*now)(void *opaque);
+    void *opaque;
+};
+
+// P-square streaming estimator of a quantile (Jain & Chlamtac, 1985), which
+// keeps five markers instead of the samples
+struct click_quantile {
+    double p;
+    unsigned count;
+    double q[5]; // marker heights
+    double n[5]; // marker positions
+    double np[5]; // desired marker positions
+};
+
+void click_quantile_init(struct click_quantile *q, double p);
+void click_quantile_add(struct click_quantile *q, double x);
+// the estimate, 0 if there are no samples yet
+double click_quantile_get(const struct click_quantile *q);
+
+// the adaptive double click window is the 99th percentile of the gaps
+// between the clicks of double clicks plus a margin, kept within
+// [CLICK_ADAPTIVE_MIN_DELAY, click_config.double_click_delay]
+#define CLICK_ADAPTIVE_QUANTILE 0.99
+#define CLICK_ADAPTIVE_MARGIN 50 // in milliseconds
+#define CLICK_ADAPTIVE_MIN_DELAY 150 // in milliseconds
+// samples needed before the estimate is trusted
+#define CLICK_ADAPTIVE_MIN_SAMPLES 20
+
+enum click_state {
+    // waiting for a click
+    CLICK_STATE_IDLE,
+    // got a click, waiting to see if it's a double click
+    CLICK_STATE_PENDING,
+    CLICK_STATES
+};
+
+struct click_machine {
+    const struct click_clock *clock;
+    enum click_state state;
+    // time of the click that has made the state pending
+    int64_t click_time;
+    // when the pending click turns into a single click
+    int64_t deadline;
+    // gaps between the clicks that are close enough to be double clicks, in
+    // microseconds
+    struct click_quantile gaps;
+    int64_t last_click_time;
+    // the adaptive window learned in a previous session, in milliseconds, 0
+    // if none. used until enough gaps are seen
+    int64_t learned_delay;
+};
+
+// actions the caller has to carry out. the ones affecting the mouse state
+// VLC sees have already been applied by the time they are returned
+enum click_action {
+    CLICK_ACTION_PAUSE_PLAY = 1 << 0,
+    // cancel the timer
+    CLICK_ACTION_TIMER_CANCEL = 1 << 1,
+    // (re)start the timer for click_machine.deadline
+    CLICK_ACTION_TIMER_START = 1 << 2,
+    // drop the double click VLC has detected
+    CLICK_ACTION_CLEAR_DOUBLE_CLICK = 1 << 3,
+    CLICK_ACTION_SET_FULLSCREEN = 1 << 4,
+    CLICK_ACTION_SUPPRESS_CONTEXT_MENU = 1 << 5,
+    CLICK_ACTION_SET_CONTEXT_MENU = 1 << 6,
+    // undo the speculative pause/play of the previous click
+    CLICK_ACTION_ROLLBACK = 1 << 7,
+    // the ones below are carried out on the player and the vouts rather than
+    // through the mouse state, see gesture.h
+    CLICK_ACTION_TOGGLE_FULLSCREEN = 1 << 8,
+    CLICK_ACTION_POPUP_MENU = 1 << 9,
+    // play at twice the rate
+    CLICK_ACTION_FAST_FORWARD = 1 << 10,
+    // go back to the rate from before CLICK_ACTION_FAST_FORWARD
+    CLICK_ACTION_NORMAL_RATE = 1 << 11,
+    // a step of VLC's short jump, or of its volume step
+    CLICK_ACTION_SEEK_FORWARD = 1 << 12,
+    CLICK_ACTION_SEEK_BACKWARD = 1 << 13,
+    CLICK_ACTION_VOLUME_UP = 1 << 14,
+    CLICK_ACTION_VOLUME_DOWN = 1 << 15,
+};
+
+// true if the mouse event can't lead to any decision
+static inline bool click_logic_is_idle(const struct click_mouse *p_new)
+{
+    return p_new->pressed == 0 && !p_new->double_click;
+}
+
+// the mouse state changes the click logic acts on under a config, as button
+// bitmasks
+struct click_interest {
+    // buttons whose press can lead to an action
+    int press;
+    // buttons whose release can lead to an action
+    int release;
+    // buttons that lead to an action for as long as they are held
+    int hold;
+};
+
+void click_interest_init(struct click_interest *p_interest, const struct click_config *cfg);
+
+// true if the mouse event can't lead to any action, so that it can be passed
+// on as is without going through the machine, e.g. moving with a button held
+// down
+static inline bool click_logic_is_uninteresting(const struct click_interest *p_interest,
+                                                const struct click_mouse *p_old,
+                                                const struct click_mouse *p_new)
+{
+    return ((p_new->pressed & ~p_old->pressed & p_interest->press) |
+            (p_old->pressed & ~p_new->pressed & p_interest->release) |
+            (p_new->pressed & p_interest->hold) | p_new->double_click) == 0;
+}
+
+void click_machine_init(struct click_machine *m, const struct click_clock *clock);
+
+// Drops a pending click without acting on it, keeping what has been learned
+// about the user's double clicks.
+void click_machine_cancel(struct click_machine *m);
+
+// the double click window in use, in milliseconds
+int64_t click_machine_delay(const struct click_machine *m, const struct click_config *cfg);
+
+// true if the adaptive window has seen enough clicks to be worth keeping
+bool click_machine_has_learned(const struct click_machine *m);
+
+// Decides what to do on a mouse event. Sets the mouse state VLC should see
+// into p_out and returns a bitmask of enum click_action.
+unsigned click_machine_mouse(struct click_machine *m, const struct click_config *cfg,
+                             const struct click_mouse *p_old, const struct click_mouse *p_new,
+                             struct click_mouse *p_out);
+
+// Decides what to do once the timer fires. Returns a bitmask of
+// enum click_action.
+unsigned click_machine_timeout(struct click_machine *m, const struct click_config *cfg);
+
+#endif
@@ -0,0 +1,341 @@
+/*****************************************************************************
+ * gesture.c : Mouse gesture bindings, independent of VLC
+ *****************************************************************************
+ * Copyright (C) 2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "gesture.h"
+
+#include <string.h>
+
+// the buttons VLC's own bindings act on, which are taken away from it once
+// bound here: the right one opens the context menu, the wheel ones are the
+// hotkeys module's wheel actions, the volume by default
+#define TAKEN_BUTTONS ((1 << CLICK_BUTTON_RIGHT) | (1 << CLICK_BUTTON_WHEEL_UP) | \
+                       (1 << CLICK_BUTTON_WHEEL_DOWN) | (1 << CLICK_BUTTON_WHEEL_LEFT) | \
+                       (1 << CLICK_BUTTON_WHEEL_RIGHT))
+
+static const char *const button_names[GESTURE_BUTTONS] = {
+    [CLICK_BUTTON_LEFT] = "left",
+    [CLICK_BUTTON_CENTER] = "middle",
+    [CLICK_BUTTON_RIGHT] = "right",
+    [CLICK_BUTTON_WHEEL_UP] = "wheel-up",
+    [CLICK_BUTTON_WHEEL_DOWN] = "wheel-down",
+    [CLICK_BUTTON_WHEEL_LEFT] = "wheel-left",
+    [CLICK_BUTTON_WHEEL_RIGHT] = "wheel-right",
+};
+
+static const char *const gesture_names[GESTURES] = {
+    [GESTURE_PRESS] = "press",
+    [GESTURE_CLICK] = "click",
+    [GESTURE_DOUBLE] = "double",
+    [GESTURE_TRIPLE] = "triple",
+    [GESTURE_HOLD] = "hold",
+};
+
+static const char *const action_names[GESTURE_ACTIONS] = {
+    [GESTURE_ACTION_NONE] = "none",
+    [GESTURE_ACTION_PAUSE] = "pause",
+    [GESTURE_ACTION_FULLSCREEN] = "fullscreen",
+    [GESTURE_ACTION_MENU] = "menu",
+    [GESTURE_ACTION_SPEED2X] = "speed2x",
+    [GESTURE_ACTION_SEEK_FORWARD] = "seek-forward",
+    [GESTURE_ACTION_SEEK_BACKWARD] = "seek-backward",
+    [GESTURE_ACTION_VOLUME_UP] = "volume-up",
+    [GESTURE_ACTION_VOLUME_DOWN] = "volume-down",
+};
+
+// returns the index of the name that matches the len long string, -1 if none
+static int lookup(const char *const *names, int count, const char *psz, size_t len)
+{
+    for (int i = 0; i < count; i ++) {
+        if (strlen(names[i]) == len && strncmp(names[i], psz, len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool gesture_table_compile(struct gesture_table *t, const char *psz_bindings, size_t *p_error)
+{
+    memset(t, 0, sizeof(*t));
+
+    const char *psz = psz_bindings;
+    while (*psz) {
+        psz += strspn(psz, " ,");
+        if (!*psz) {
+            break;
+        }
+        const char *psz_binding = psz;
+        size_t len = strcspn(psz, ":, ");
+        const int button = lookup(button_names, GESTURE_BUTTONS, psz, len);
+        psz += len;
+        if (button < 0 || *psz != ':') {
+            goto error;
+        }
+        psz ++;
+        len = strcspn(psz, "=, ");
+        const int gesture = lookup(gesture_names, GESTURES, psz, len);
+        psz += len;
+        if (gesture < 0 || *psz != '=') {
+            goto error;
+        }
+        psz ++;
+        len = strcspn(psz, ", ");
+        const int action = lookup(action_names, GESTURE_ACTIONS, psz, len);
+        psz += len;
+        if (action < 0) {
+            goto error;
+        }
+        t->actions[button][gesture] = action;
+        continue;
+error:
+        *p_error = psz_binding - psz_bindings;
+        memset(t, 0, sizeof(*t));
+        return false;
+    }
+
+    gesture_table_finish(t);
+
+    return true;
+}
+
+void gesture_table_finish(struct gesture_table *t)
+{
+    t->bound = 0;
+    memset(t->max_clicks, 0, sizeof(t->max_clicks));
+    for (int b = 0; b < GESTURE_BUTTONS; b ++) {
+        for (int g = 0; g < GESTURES; g ++) {
+            if (t->actions[b][g] == GESTURE_ACTION_NONE) {
+                continue;
+            }
+            t->bound |= 1 << b;
+            if (GESTURE_CLICK <= g && g <= GESTURE_TRIPLE) {
+                t->max_clicks[b] = g - GESTURE_CLICK + 1;
+            }
+        }
+    }
+}
+
+void gesture_interest_init(struct click_interest *p_interest, const struct gesture_table *t)
+{
+    p_interest->press = t->bound;
+    p_interest->release = t->bound;
+    // the right and the wheel buttons are dropped from the mouse state for as
+    // long as they are held, see gesture_machine_mouse()
+    p_interest->hold = t->bound & TAKEN_BUTTONS;
+}
+
+void gesture_machine_init(struct gesture_machine *m, const struct click_clock *clock)
+{
+    m->clock = clock;
+    m->button = CLICK_BUTTON_NONE;
+    m->clicks = 0;
+    m->pressed = false;
+    m->held = false;
+    m->press_time = 0;
+    m->fast = false;
+    m->deadline = 0;
+}
+
+static unsigned act(struct gesture_machine *m, enum gesture_action action)
+{
+    switch (action) {
+        case GESTURE_ACTION_PAUSE:
+            return CLICK_ACTION_PAUSE_PLAY;
+        case GESTURE_ACTION_FULLSCREEN:
+            return CLICK_ACTION_TOGGLE_FULLSCREEN;
+        case GESTURE_ACTION_MENU:
+            return CLICK_ACTION_POPUP_MENU;
+        case GESTURE_ACTION_SPEED2X:
+            m->fast = !m->fast;
+            return m->fast ? CLICK_ACTION_FAST_FORWARD : CLICK_ACTION_NORMAL_RATE;
+        case GESTURE_ACTION_SEEK_FORWARD:
+            return CLICK_ACTION_SEEK_FORWARD;
+        case GESTURE_ACTION_SEEK_BACKWARD:
+            return CLICK_ACTION_SEEK_BACKWARD;
+        case GESTURE_ACTION_VOLUME_UP:
+            return CLICK_ACTION_VOLUME_UP;
+        case GESTURE_ACTION_VOLUME_DOWN:
+            return CLICK_ACTION_VOLUME_DOWN;
+        default:
+            return 0;
+    }
+}
+
+static void forget(struct gesture_machine *m)
+{
+    m->button = CLICK_BUTTON_NONE;
+    m->clicks = 0;
+    m->pressed = false;
+    m->held = false;
+}
+
+unsigned gesture_machine_cancel(struct gesture_machine *m)
+{
+    unsigned actions = 0;
+    // no release is coming to end the fast forward of the hold
+    if (m->held && m->fast) {
+        m->fast = false;
+        actions = CLICK_ACTION_NORMAL_RATE;
+    }
+    forget(m);
+    m->deadline = 0;
+    return actions;
+}
+
+// ends the hold of the button, along with its fast forward, which lasts for
+// as long as the hold
+static unsigned end_hold(struct gesture_machine *m, const struct gesture_table *t)
+{
+    unsigned actions = 0;
+    if (t->actions[m->button][GESTURE_HOLD] == GESTURE_ACTION_SPEED2X && m->fast) {
+        actions = act(m, GESTURE_ACTION_SPEED2X);
+    }
+    forget(m);
+    return actions;
+}
+
+// fires the gesture of the clicks counted so far
+static unsigned resolve(struct gesture_machine *m, const struct gesture_table *t)
+{
+    unsigned actions = 0;
+    if (m->button != CLICK_BUTTON_NONE && m->clicks > 0) {
+        const unsigned clicks = m->clicks < 3 ? m->clicks : 3;
+        actions = act(m, t->actions[m->button][GESTURE_CLICK + clicks - 1]);
+    }
+    forget(m);
+    return actions;
+}
+
+// whether nothing more can come of the clicks counted so far
+static bool is_final(const struct gesture_machine *m, const struct gesture_table *t)
+{
+    return m->clicks >= t->max_clicks[m->button] && (!m->pressed || !t->actions[m->button][GESTURE_HOLD]);
+}
+
+// sets the deadline for what the machine is waiting for, returning the timer
+// actions for the caller
+static unsigned schedule(struct gesture_machine *m, const struct gesture_table *t, int64_t double_click_delay)
+{
+    const int64_t prev = m->deadline;
+    m->deadline = 0;
+    if (m->button != CLICK_BUTTON_NONE) {
+        if (m->pressed && !m->held && t->actions[m->button][GESTURE_HOLD]) {
+            m->deadline = m->press_time + GESTURE_HOLD_DELAY*1000;
+        } else if (!m->pressed && m->clicks > 0) {
+            m->deadline = m->press_time + double_click_delay*1000;
+        }
+    }
+    if (m->deadline) {
+        return CLICK_ACTION_TIMER_START;
+    }
+    return prev ? CLICK_ACTION_TIMER_CANCEL : 0;
+}
+
+unsigned gesture_machine_mouse(struct gesture_machine *m, const struct gesture_table *t,
+                               int64_t double_click_delay, bool double_click_is_click,
+                               const struct click_mouse *p_old, const struct click_mouse *p_new,
+                               struct click_mouse *p_out)
+{
+    unsigned actions = 0;
+
+    *p_out = *p_new;
+    if (t->bound & (1 << CLICK_BUTTON_LEFT)) {
+        p_out->double_click = false;
+    }
+    p_out->pressed &= ~(t->bound & TAKEN_BUTTONS);
+
+    const int released = p_old->pressed & ~p_new->pressed;
+    int pressed = p_new->pressed & ~p_old->pressed & t->bound;
+    // the second click of a fast double click, which comes without the left
+    // button being pressed and released
+    int clicked = 0;
+    if (double_click_is_click && p_new->double_click && !p_old->double_click &&
+            !(p_new->pressed & (1 << CLICK_BUTTON_LEFT))) {
+        clicked = t->bound & (1 << CLICK_BUTTON_LEFT);
+        pressed |= clicked;
+    }
+    if (!pressed && !(m->pressed && released & (1 << m->button))) {
+        return actions;
+    }
+    const int64_t now = m->clock->now(m->clock->opaque);
+
+    if (m->pressed && released & (1 << m->button)) {
+        m->pressed = false;
+        if (m->held) {
+            actions |= end_hold(m, t);
+        } else if (is_final(m, t) || now >= m->press_time + double_click_delay*1000) {
+            actions |= resolve(m, t);
+        }
+    }
+
+    for (int b = 0; pressed; b ++, pressed >>= 1) {
+        if (!(pressed & 1)) {
+            continue;
+        }
+        // a press during a hold ends it, as its release is then ignored
+        if (m->held) {
+            actions |= end_hold(m, t);
+        // another button, or too late to be the next click of the same one
+        } else if (m->button != b || now >= m->press_time + double_click_delay*1000) {
+            actions |= resolve(m, t);
+        }
+        actions |= act(m, t->actions[b][GESTURE_PRESS]);
+        if (t->max_clicks[b] || t->actions[b][GESTURE_HOLD]) {
+            m->button = b;
+            m->clicks ++;
+            m->pressed = true;
+            m->held = false;
+            m->press_time = now;
+            // no release is coming for it
+            if (clicked & (1 << b)) {
+                m->pressed = false;
+            }
+            if (is_final(m, t)) {
+                actions |= resolve(m, t);
+            }
+        }
+    }
+
+    return actions | schedule(m, t, double_click_delay);
+}
+
+unsigned gesture_machine_timeout(struct gesture_machine *m, const struct gesture_table *t,
+                                 int64_t double_click_delay)
+{
+    unsigned actions = 0;
+    const int64_t now = m->clock->now(m->clock->opaque);
+
+    if (m->button != CLICK_BUTTON_NONE) {
+        const int b = m->button;
+        if (m->pressed && !m->held && t->actions[b][GESTURE_HOLD] &&
+                now >= m->press_time + GESTURE_HOLD_DELAY*1000) {
+            m->held = true;
+            m->clicks = 0;
+            actions |= act(m, t->actions[b][GESTURE_HOLD]);
+        } else if (!m->pressed && m->clicks > 0 && now >= m->press_time + double_click_delay*1000) {
+            actions |= resolve(m, t);
+        }
+    }
+
+    return actions | schedule(m, t, double_click_delay);
+}
@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * gesture.h : Mouse gesture bindings, independent of VLC
+ *****************************************************************************
+ * Copyright (C) 2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "click_logic.h"
+
+// User defined bindings of mouse gestures to actions, as an alternative to the
+// fixed pause/play, fullscreen and context menu buttons of click_logic.h.
+//
+// The bindings are given as a string such as
+//
+//   left:click=pause,left:double=fullscreen,middle:hold=speed2x,
+//   wheel-up:press=seek-forward,wheel-down:press=seek-backward
+//
+// which is compiled once into a dense (button, gesture) -> action table, so
+// that an event costs a single lookup no matter how many bindings there are.
+// Like the click machine, the gesture machine doesn't run timers itself but
+// tells the caller when to start or cancel one for its deadline.
+
+#define GESTURE_BUTTONS (CLICK_BUTTON_WHEEL_RIGHT + 1)
+
+// how long a button has to be held down for a hold, in milliseconds
+#define GESTURE_HOLD_DELAY 500
+
+enum gesture {
+    // fires right on the press, without waiting for more clicks
+    GESTURE_PRESS,
+    GESTURE_CLICK,
+    GESTURE_DOUBLE,
+    GESTURE_TRIPLE,
+    // the button is held down for GESTURE_HOLD_DELAY, ends on release
+    GESTURE_HOLD,
+    GESTURES
+};
+
+enum gesture_action {
+    GESTURE_ACTION_NONE,
+    GESTURE_ACTION_PAUSE,
+    GESTURE_ACTION_FULLSCREEN,
+    GESTURE_ACTION_MENU,
+    // toggles playing at twice the rate, for the duration of a hold
+    GESTURE_ACTION_SPEED2X,
+    // meant for the scroll wheel, whose notches the caller can batch up
+    GESTURE_ACTION_SEEK_FORWARD,
+    GESTURE_ACTION_SEEK_BACKWARD,
+    GESTURE_ACTION_VOLUME_UP,
+    GESTURE_ACTION_VOLUME_DOWN,
+    GESTURE_ACTIONS
+};
+
+struct gesture_table {
+    uint8_t actions[GESTURE_BUTTONS][GESTURES]; // enum gesture_action
+    // the most clicks bound per button, so that the last one fires without
+    // waiting out the double click interval
+    uint8_t max_clicks[GESTURE_BUTTONS];
+    // bitmask of the buttons with any binding
+    int bound;
+};
+
+// Compiles the bindings string into the table. Returns false on a syntax
+// error, setting *p_error to the offset of the offending binding.
+bool gesture_table_compile(struct gesture_table *t, const char *psz_bindings, size_t *p_error);
+
+// Fills in the rest of the table from its actions, for a table whose actions
+// have been set by other means than compiling, e.g. read from a trace.
+void gesture_table_finish(struct gesture_table *t);
+
+static inline bool gesture_table_is_empty(const struct gesture_table *t)
+{
+    return t->bound == 0;
+}
+
+void gesture_interest_init(struct click_interest *p_interest, const struct gesture_table *t);
+
+struct gesture_machine {
+    const struct click_clock *clock;
+    // the button whose clicks are being counted, CLICK_BUTTON_NONE if none
+    int button;
+    unsigned clicks;
+    bool pressed;
+    // the press has turned into a hold
+    bool held;
+    int64_t press_time;
+    // playing at twice the rate
+    bool fast;
+    // when to call gesture_machine_timeout(), 0 if not needed
+    int64_t deadline;
+};
+
+void gesture_machine_init(struct gesture_machine *m, const struct click_clock *clock);
+
+// Drops the clicks counted so far and a press being held without acting on
+// them. Returns CLICK_ACTION_NORMAL_RATE if the held press was playing fast.
+unsigned gesture_machine_cancel(struct gesture_machine *m);
+
+// Handles a mouse event, returning enum click_action flags. p_out gets the
+// mouse state to pass on to VLC: its double click detection is dropped when
+// the left button is bound, and so are the right and the wheel buttons when
+// they are bound, so that VLC's own fullscreen, context menu and wheel
+// hotkeys don't get in the way.
+// double_click_delay is in milliseconds. With double_click_is_click, a
+// double click without the left button pressed counts as a click of it, see
+// click_config.double_click_is_click.
+unsigned gesture_machine_mouse(struct gesture_machine *m, const struct gesture_table *t,
+                               int64_t double_click_delay, bool double_click_is_click,
+                               const struct click_mouse *p_old, const struct click_mouse *p_new,
+                               struct click_mouse *p_out);
+
+// Called once the deadline has passed, returns enum click_action flags.
+unsigned gesture_machine_timeout(struct gesture_machine *m, const struct gesture_table *t,
+                                 int64_t double_click_delay);
+
+#endif
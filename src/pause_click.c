@@ -34,6 +34,11 @@
 #endif
 
 #include <vlc/libvlc_version.h>
+#include "click_logic.h"
+#include "gesture.h"
+#include "ring.h"
+#include "timer_wheel.h"
+#include "trace.h"
 #include "version.h"
 
 #if LIBVLC_VERSION_MAJOR >= 3
@@ -43,7 +48,9 @@
 
 #include <vlc_atomic.h>
 #include <vlc_common.h>
+#include <vlc_configuration.h>
 #include <vlc_filter.h>
+#include <vlc_fs.h>
 #include <vlc_input.h>
 #include <vlc_messages.h>
 #include <vlc_mouse.h>
@@ -58,6 +65,7 @@
 #include <vlc_threads.h>
 #include <vlc_vout.h>
 #include <vlc_vout_osd.h>
+#include "vlc_compat.h"
 
 #if LIBVLC_VERSION_MAJOR == 2 && LIBVLC_VERSION_MINOR == 1
 # include "third_party/vlc/2.1.0/include/vlc_interface.h"
@@ -75,6 +83,16 @@ static const char *const mouse_button_names[] = {N_("None"), N_("Left Button"),
 static const int mouse_button_values_index[] = {0, 1, 2, 3, 4, 5, 6, 7};
 static const int mouse_button_values[] = {-1, MOUSE_BUTTON_LEFT, MOUSE_BUTTON_CENTER, MOUSE_BUTTON_RIGHT, MOUSE_BUTTON_WHEEL_UP, MOUSE_BUTTON_WHEEL_DOWN, MOUSE_BUTTON_WHEEL_LEFT, MOUSE_BUTTON_WHEEL_RIGHT};
 
+// click_logic.h numbers the mouse buttons on its own, so that it doesn't depend on VLC
+_Static_assert((int) CLICK_BUTTON_LEFT == (int) MOUSE_BUTTON_LEFT &&
+               (int) CLICK_BUTTON_CENTER == (int) MOUSE_BUTTON_CENTER &&
+               (int) CLICK_BUTTON_RIGHT == (int) MOUSE_BUTTON_RIGHT &&
+               (int) CLICK_BUTTON_WHEEL_UP == (int) MOUSE_BUTTON_WHEEL_UP &&
+               (int) CLICK_BUTTON_WHEEL_DOWN == (int) MOUSE_BUTTON_WHEEL_DOWN &&
+               (int) CLICK_BUTTON_WHEEL_LEFT == (int) MOUSE_BUTTON_WHEEL_LEFT &&
+               (int) CLICK_BUTTON_WHEEL_RIGHT == (int) MOUSE_BUTTON_WHEEL_RIGHT,
+               "mouse button numbering doesn't match VLC's");
+
 #define CFG_PREFIX "pause-click-"
 
 #define MOUSE_BUTTON_CFG CFG_PREFIX "mouse-button"
@@ -89,6 +107,16 @@ static const int mouse_button_values[] = {-1, MOUSE_BUTTON_LEFT, MOUSE_BUTTON_CE
 #define IGNORE_DOUBLE_CLICK_CFG CFG_PREFIX "ignore-double-click"
 #define IGNORE_DOUBLE_CLICK_DEFAULT false
 
+#define SPECULATIVE_CFG CFG_PREFIX "speculative"
+#define SPECULATIVE_DEFAULT false
+
+#define ADAPTIVE_DOUBLE_CLICK_DELAY_CFG CFG_PREFIX "adaptive-double-click-delay"
+#define ADAPTIVE_DOUBLE_CLICK_DELAY_DEFAULT false
+
+// not a setting, the adaptive double click interval kept across restarts
+#define LEARNED_DOUBLE_CLICK_DELAY_CFG CFG_PREFIX "learned-double-click-delay"
+#define LEARNED_DOUBLE_CLICK_DELAY_DEFAULT 0
+
 #define DISABLE_FS_TOGGLE_CFG CFG_PREFIX "disable-fs-toggle"
 #define DISABLE_FS_TOGGLE_DEFAULT false
 
@@ -101,20 +129,373 @@ static const int mouse_button_values[] = {-1, MOUSE_BUTTON_LEFT, MOUSE_BUTTON_CE
 #define CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_CFG CFG_PREFIX "context-menu-toggle-mouse-button"
 #define CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_DEFAULT 0 // None
 
+#define GESTURES_CFG CFG_PREFIX "gestures"
+#define GESTURES_DEFAULT ""
+
 #define DISPLAY_ICON_CFG CFG_PREFIX "display-icon"
 #define DISPLAY_ICON_DEFAULT true
 
+#define DISPLAY_ICON_ON_ALL_VOUTS_CFG CFG_PREFIX "display-icon-on-all-vouts"
+#define DISPLAY_ICON_ON_ALL_VOUTS_DEFAULT false
+
+#define MOUSE_ONLY_CFG CFG_PREFIX "mouse-only"
+#define MOUSE_ONLY_DEFAULT false
+
+#define FRAME_ACCURATE_CFG CFG_PREFIX "frame-accurate"
+#define FRAME_ACCURATE_DEFAULT false
+
+#define FRAME_PACING_CFG CFG_PREFIX "frame-pacing"
+#define FRAME_PACING_DEFAULT false
+
+#define COALESCE_WINDOW_CFG CFG_PREFIX "coalesce-window"
+#define COALESCE_WINDOW_DEFAULT 0
+
+#define DEFERRED_LOG_CFG CFG_PREFIX "deferred-log"
+#define DEFERRED_LOG_DEFAULT true
+
+#define TRACE_FILE_CFG CFG_PREFIX "trace-file"
+#define TRACE_FILE_DEFAULT NULL
+
+#define DEBUG_CFG CFG_PREFIX "debug"
+#define DEBUG_DEFAULT false
+
 static int OpenFilter(vlc_object_t *);
 static void CloseFilter(vlc_object_t *);
 static int OpenInterface(vlc_object_t *);
 static void CloseInterface(vlc_object_t *);
 
 
-static intf_thread_t *p_intf = NULL;
+// The interface publishes its context in this variable of its libvlc instance,
+// so that the filters of the same instance can find it. Each libvlc instance
+// in the process has its own interface and thus its own context.
+#define INTF_VAR CFG_PREFIX "intf"
+
+// serializes the filters looking the context up with the interface
+// (un)publishing it
+static vlc_mutex_t intf_lock = VLC_STATIC_MUTEX;
+
+// HDR-style log-linear histogram of durations in microseconds. Values are
+// bucketed by their power of two and then linearly by the next
+// HISTOGRAM_SUB_BITS bits, which keeps the relative error under 1/2^SUB_BITS
+// while covering the whole int64_t range in a few hundred buckets.
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS)
+
+struct histogram {
+    atomic_uint counts[HISTOGRAM_BUCKETS];
+    atomic_uint total;
+    atomic_uint_least64_t max;
+};
+
+// stages of the way from a mouse click to the player changing its state
+enum latency_stage {
+    // the click's mouse event to the delayed click timer firing
+    LATENCY_CLICK_TO_TIMER,
+    // the click's mouse event to pause/play being dispatched on the
+    // interface thread
+    LATENCY_CLICK_TO_DISPATCH,
+    // the pause/play player control call itself, including the lock wait
+    LATENCY_CONTROL,
+    // the click's mouse event to the pause/play player control call returning
+    LATENCY_CLICK_TO_APPLIED,
+    // the click's mouse event to the player reporting the state change
+    LATENCY_CLICK_TO_OBSERVED,
+    // not a latency: how far past the clicked picture the player has paused
+    LATENCY_FRAME_DRIFT,
+    // the resume call to the first new picture reaching the filter
+    LATENCY_RESUME_TO_FRAME,
+    // not a latency: how far the pictures after a resume are off the frame
+    // rate, or the time between them if it's unknown
+    LATENCY_RESUME_JITTER,
+    LATENCY_STAGES
+};
+
+static const char *const latency_stage_names[] = {
+    [LATENCY_CLICK_TO_TIMER] = "click-to-timer",
+    [LATENCY_CLICK_TO_DISPATCH] = "click-to-dispatch",
+    [LATENCY_CONTROL] = "control",
+    [LATENCY_CLICK_TO_APPLIED] = "click-to-applied",
+    [LATENCY_CLICK_TO_OBSERVED] = "click-to-observed",
+    [LATENCY_FRAME_DRIFT] = "frame-drift",
+    [LATENCY_RESUME_TO_FRAME] = "resume-to-frame",
+    [LATENCY_RESUME_JITTER] = "resume-jitter",
+};
+
+#define LATENCY_VAR CFG_PREFIX "latency"
+
+// what the hot paths have done, published as read-only integer variables on
+// the interface, so that they can be read from the Lua and RC interfaces
+// without the debug logging. The variables are snapshots refreshed every
+// COUNTERS_PERIOD, see counters_publish()
+enum counter {
+    // mouse events seen
+    COUNTER_EVENTS,
+    // mouse events returned on early, as they can't lead to any action
+    COUNTER_EARLY_OUTS,
+    // pause/play carried out on the player
+    COUNTER_TOGGLES,
+    // pause/play folded into another one by the coalescing
+    COUNTER_TOGGLES_ABSORBED,
+    COUNTER_TIMERS_SCHEDULED,
+    COUNTER_TIMERS_CANCELLED,
+    COUNTER_TIMERS_FIRED,
+    COUNTER_SPECULATIONS,
+    COUNTER_ROLLBACKS,
+    // double clicks passed on to VLC to toggle fullscreen
+    COUNTER_FULLSCREEN,
+    // pause/play not carried out because of being in a menu
+    COUNTER_MENU_SUPPRESSIONS,
+    // walks over the vouts to display the icon
+    COUNTER_VOUT_ENUMERATIONS,
+    COUNTER_COMMANDS_DROPPED,
+    // scroll wheel notches bound to a seek or the volume
+    COUNTER_WHEEL_NOTCHES,
+    // seeks and volume changes the notches have been batched up into
+    COUNTER_WHEEL_BATCHES,
+    COUNTERS
+};
+
+static const char *const counter_names[] = {
+    [COUNTER_EVENTS] = CFG_PREFIX "events",
+    [COUNTER_EARLY_OUTS] = CFG_PREFIX "early-outs",
+    [COUNTER_TOGGLES] = CFG_PREFIX "toggles",
+    [COUNTER_TOGGLES_ABSORBED] = CFG_PREFIX "toggles-absorbed",
+    [COUNTER_TIMERS_SCHEDULED] = CFG_PREFIX "timers-scheduled",
+    [COUNTER_TIMERS_CANCELLED] = CFG_PREFIX "timers-cancelled",
+    [COUNTER_TIMERS_FIRED] = CFG_PREFIX "timers-fired",
+    [COUNTER_SPECULATIONS] = CFG_PREFIX "speculations",
+    [COUNTER_ROLLBACKS] = CFG_PREFIX "rollbacks",
+    [COUNTER_FULLSCREEN] = CFG_PREFIX "fullscreen-toggles",
+    [COUNTER_MENU_SUPPRESSIONS] = CFG_PREFIX "menu-suppressions",
+    [COUNTER_VOUT_ENUMERATIONS] = CFG_PREFIX "vout-enumerations",
+    [COUNTER_COMMANDS_DROPPED] = CFG_PREFIX "commands-dropped",
+    [COUNTER_WHEEL_NOTCHES] = CFG_PREFIX "wheel-notches",
+    [COUNTER_WHEEL_BATCHES] = CFG_PREFIX "wheel-batches",
+};
+
+// how often the counter variables are brought up to date, in microseconds
+#define COUNTERS_PERIOD 1000000
+
+// how long after a resume the pictures are measured for, in microseconds
+#define FRAME_PACING_WINDOW 3000000
+
+// how long the scroll wheel notches wait for a picture to be flushed with, in
+// microseconds
+#define SCROLL_FLUSH_DELAY 100000
+
+enum pause_play_flag {
+    // remember the player for a rollback
+    PAUSE_PLAY_SPECULATIVE = 1 << 0,
+    // display the icon on the clicked vout
+    PAUSE_PLAY_ICON = 1 << 1,
+    // display the icon on all the vouts instead
+    PAUSE_PLAY_ICON_ALL_VOUTS = 1 << 2,
+};
+
+// commands the mouse and timer callbacks queue up for the interface thread
+enum command {
+    // args: click time, the clicked vout or 0 if unknown, date of the clicked
+    // picture to pause on or 0, enum pause_play_flag flags
+    COMMAND_PAUSE_PLAY,
+    // undo the last speculative pause/play
+    COMMAND_ROLLBACK,
+    // go back to the clicked picture once paused
+    COMMAND_FRAME_SEEK,
+    COMMAND_TOGGLE_FULLSCREEN,
+    COMMAND_POPUP_MENU,
+    // args: whether to play at twice the rate or go back to the normal one
+    COMMAND_SET_FAST,
+    // args: the number of short jumps to seek by, negative to seek backward
+    COMMAND_JUMP,
+    // args: the number of volume steps, negative to turn it down
+    COMMAND_CHANGE_VOLUME,
+    // the coalescing window has ended
+    COMMAND_COALESCE_END,
+};
+
+struct intf_sys_t {
+    // held by the interface and by every filter that has found the context,
+    // so the context outlives the interface until the last filter is closed
+    atomic_uint refs;
+    vlc_thread_t thread;
+    vlc_sem_t wakeup;
+    atomic_bool stop;
+    struct ring commands;
+    bool deferred_log;
+    struct ring log;
+    // set once the interface thread has been woken up for the queued records,
+    // cleared by it before draining them
+    atomic_bool log_wakeup;
+    atomic_uint log_dropped;
+    struct histogram latency[LATENCY_STAGES];
+    atomic_bool latency_updated;
+    FILE *trace;
+
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    // whether the input is in a menu, kept up to date by its title events,
+    // as asking the input for its title allocates
+    atomic_bool in_menu;
+#endif
+    // time of the click whose state change we are waiting for
+    atomic_int_least64_t observed_click_time;
+    // the vout whose filter has the clicked picture to go back to once
+    // paused, 0 if none
+    atomic_uintptr_t pause_vout;
+    bool frame_pacing;
+    // time of the last resume made by pause/play, 0 if none or not measuring
+    atomic_int_least64_t resume_time;
+
+    // the player before the last speculative pause/play, used only by the
+    // interface thread
+    struct {
+        bool valid;
+        bool playing;
+        int64_t time;
+    } rollback;
+    // the rate to go back to after playing at twice it, used only by the
+    // interface thread
+    float normal_rate;
+
+    // pause/plays held back until the end of the coalescing window, used only
+    // by the interface thread
+    struct {
+        // in microseconds, 0 if disabled
+        int64_t window;
+        // the end of the window, 0 if none is open
+        int64_t end;
+        unsigned pending;
+        // the args of the last one held back
+        int64_t args[4];
+        struct timer_wheel_entry timer;
+    } coalesce;
+
+    atomic_uint counters[COUNTERS];
+    // the values last published, written only by the interface thread
+    atomic_uint counters_published[COUNTERS];
+    // wakes the interface thread up to publish the counters, runs only while
+    // there are vouts to bump them
+    struct timer_wheel *wheel;
+    struct timer_wheel_entry counters_timer;
+    atomic_bool counters_active;
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    vlc_mutex_t input_lock;
+    input_thread_t *input;
+#elif LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_listener_id *player_listener;
+#endif
+
+    // the click handling state in the mouse-only mode, NULL otherwise
+    struct filter_sys_t *mouse_only;
+
+    // states of closed filters for the next filters to take over, guarded by
+    // intf_lock. no longer filled once the interface is closing
+    struct filter_sys_t *pool;
+    bool pool_open;
+    // bumped whenever the current input changes, tells a filter reopened on
+    // a vout for the next item from one reopened on a reconfiguration
+    atomic_uint input_changes;
+
+    // held vouts of the current input, kept up to date by the player events
+    vlc_mutex_t vouts_lock;
+    vout_thread_t **vouts;
+    size_t vouts_count;
+    size_t vouts_capacity;
+    // the open filters, guarded by vouts_lock
+    struct filter_sys_t *filters;
+};
+
+// An immutable snapshot of the filter's settings, so that the mouse callback
+// doesn't have to inherit every variable on every mouse event. A new snapshot
+// is built and published whenever one of the settings changes, the previous
+// ones are kept around while a mouse or a timer callback might still be
+// reading them, see config_acquire().
+struct config {
+    unsigned version;
+    struct click_config click;
+    // replaces the fixed buttons of click when not empty
+    struct gesture_table gestures;
+    // derived from click or gestures, for the fast path of the mouse callback
+    struct click_interest interest;
+    bool display_icon;
+    bool display_icon_on_all_vouts;
+    bool frame_accurate;
+    // the snapshot this one has replaced
+    const struct config *p_prev;
+};
+
+// The click handling state of a filter, or of the interface in the mouse-only
+// mode, where it's shared by all the vouts.
+struct filter_sys_t {
+    // the object that owns the state
+    vlc_object_t *obj;
+    bool mouse_only;
+    // context of the interface of our libvlc instance, referenced
+    intf_sys_t *intf;
+    struct timer_wheel *wheel;
+    struct timer_wheel_entry timer;
+    atomic_uintptr_t config; // const struct config *
+    atomic_uint config_version;
+    // the mouse and the timer callbacks reading a snapshot
+    atomic_uint config_readers;
+    // serializes the publishing of the snapshots
+    vlc_mutex_t config_lock;
+    // protects the machine, which is driven by both the mouse and the timer
+    // callbacks
+    vlc_mutex_t lock;
+    struct click_machine machine;
+    struct gesture_machine gestures;
+    // date of the picture on the screen at the pending click
+    int64_t click_frame_date;
+    // the vout of the pending click, only compared against the held vouts
+    vlc_object_t *click_vout;
+    // net scroll wheel notches bound to a seek and to the volume since the
+    // last picture, flushed by the filter once per picture
+    atomic_int scroll_jumps;
+    atomic_int scroll_volume;
+    // flushes the notches when no picture comes, e.g. while paused
+    struct timer_wheel_entry scroll_timer;
+    atomic_bool scroll_timer_armed;
+    // the next state in the pool
+    struct filter_sys_t *p_next;
+    // the vout and the input_changes the state was parked from, only
+    // compared against
+    vlc_object_t *parked_vout;
+    unsigned parked_input;
+    // the vout the open filter is in, NULL in the mouse-only mode
+    vlc_object_t *vout;
+    // the next open filter
+    struct filter_sys_t *p_next_open;
+    // date of the last picture that went through the filter
+    atomic_int_least64_t last_picture_date;
+    // date of the clicked picture to go back to once paused, 0 if none
+    atomic_int_least64_t pause_frame_date;
+    // the frame period of the filter's format in microseconds, 0 if unknown
+    int64_t frame_period;
+    // the resume whose pictures are measured, and the last picture's arrival
+    // time, 0 once past FRAME_PACING_WINDOW. used only by filter()
+    int64_t pacing_resume;
+    int64_t pacing_last;
+};
 
-static vlc_timer_t timer;
-static bool timer_initialized = false;
-static atomic_bool timer_scheduled;
+static const struct {
+    const char *name;
+    int type;
+} config_vars[] = {
+    {MOUSE_BUTTON_CFG, VLC_VAR_INTEGER},
+    {DOUBLE_CLICK_DELAY_CFG, VLC_VAR_INTEGER},
+    {ENABLE_DOUBLE_CLICK_DELAY_CFG, VLC_VAR_BOOL},
+    {IGNORE_DOUBLE_CLICK_CFG, VLC_VAR_BOOL},
+    {SPECULATIVE_CFG, VLC_VAR_BOOL},
+    {ADAPTIVE_DOUBLE_CLICK_DELAY_CFG, VLC_VAR_BOOL},
+    {DISABLE_FS_TOGGLE_CFG, VLC_VAR_BOOL},
+    {FS_TOGGLE_MOUSE_BUTTON_CFG, VLC_VAR_INTEGER},
+    {DISABLE_CONTEXT_MENU_TOGGLE_CFG, VLC_VAR_BOOL},
+    {CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_CFG, VLC_VAR_INTEGER},
+    {GESTURES_CFG, VLC_VAR_STRING},
+    {DISPLAY_ICON_CFG, VLC_VAR_BOOL},
+    {DISPLAY_ICON_ON_ALL_VOUTS_CFG, VLC_VAR_BOOL},
+    {FRAME_ACCURATE_CFG, VLC_VAR_BOOL},
+};
 
 // VLC 4.0 removed the advanced flag in 3716a7da5ba8dc30dbd752227c6a893c71a7495b
 #if LIBVLC_VERSION_MAJOR >= 4
@@ -124,10 +505,13 @@ static atomic_bool timer_scheduled;
     add_integer(name, value, text, longtext)
 # define _add_integer_with_range(name, value, i_min, i_max, text, longtext, advc) \
     add_integer_with_range(name, value, i_min, i_max, text, longtext)
+# define _add_string(name, value, text, longtext, advc) \
+    add_string(name, value, text, longtext)
 #else
 # define _add_bool add_bool
 # define _add_integer add_integer
 # define _add_integer_with_range add_integer_with_range
+# define _add_string add_string
 #endif
 
 // VLC 4.0 made set_help() render as a plain text, introducing set_html_help()
@@ -182,6 +566,33 @@ vlc_module_begin()
               N_("Show pause/play icon animations"),
               N_("Overlay pause and play icons on the video when it's paused and "
               "played respectively."), false)
+    _add_bool(DISPLAY_ICON_ON_ALL_VOUTS_CFG, DISPLAY_ICON_ON_ALL_VOUTS_DEFAULT,
+              N_("Show the icon on all video outputs"),
+              N_("Show the pause/play icon on every video output of the video, "
+              "e.g. of a clone or a wall, instead of only on the clicked one."), false)
+    _add_bool(MOUSE_ONLY_CFG, MOUSE_ONLY_DEFAULT,
+              N_("Watch the mouse without a video filter"),
+              N_("Get the mouse clicks from the video output instead of "
+              "inserting a video filter, so that the plugin never gets in the way "
+              "of hardware decoding. The video filter doesn't need to be enabled "
+              "in this mode, except for the video outputs that don't report "
+              "their mouse, which are left to it. The fullscreen and context "
+              "menu options are ignored in this mode."), false)
+    _add_bool(FRAME_ACCURATE_CFG, FRAME_ACCURATE_DEFAULT,
+              N_("Pause on the clicked frame"),
+              N_("Once paused, go back to the frame that was on the screen at "
+              "the moment of the click, instead of staying on the few frames "
+              "later the player has stopped at. Doesn't work in the mouse-only "
+              "mode."), false)
+    _add_integer_with_range(COALESCE_WINDOW_CFG, COALESCE_WINDOW_DEFAULT,
+                            0, 5000, N_("Fold rapid pause/play toggles (milliseconds)"),
+                            N_("Pause/plays that follow the previous one within "
+                            "this time interval are held back and folded into at most "
+                            "one, carried out at the end of the interval, so that a "
+                            "burst of clicks or a bouncing mouse button doesn't keep "
+                            "restarting the audio and video output. The first "
+                            "pause/play of a burst still happens right away. 0 "
+                            "disables it."), false)
     set_section(N_("Double click behavior"), NULL)
     _add_bool(ENABLE_DOUBLE_CLICK_DELAY_CFG, ENABLE_DOUBLE_CLICK_DELAY_DEFAULT,
               N_("Enable the custom double click interval"),
@@ -199,22 +610,85 @@ vlc_module_begin()
               "pause/play action by the double click interval, so the experience "
               "might not be as snappy as with this option disabled."
               "\n\n*Forces the use of the custom double click interval."), false)
+    _add_bool(SPECULATIVE_CFG, SPECULATIVE_DEFAULT,
+              N_("Pause/play right away, undo it on double click"),
+              N_("Instead of waiting out the double click interval, pause/play "
+              "on the first click, and if it turns out to be a double click, "
+              "put the video back the way it was before going fullscreen. "
+              "Only has effect if preventing pause/play on double click is "
+              "enabled."), false)
+    _add_bool(ADAPTIVE_DOUBLE_CLICK_DELAY_CFG, ADAPTIVE_DOUBLE_CLICK_DELAY_DEFAULT,
+              N_("Learn the double click interval"),
+              N_("Shorten the double click interval to how fast you actually "
+              "double click, learned from your clicks and remembered across "
+              "restarts. The interval never gets longer than the custom double "
+              "click interval, so set that one to the longest you would want."), false)
+    _add_integer(LEARNED_DOUBLE_CLICK_DELAY_CFG, LEARNED_DOUBLE_CLICK_DELAY_DEFAULT,
+                 N_("Learned double click interval (milliseconds)"),
+                 N_("The double click interval learned so far, 0 if none."), true)
+    change_private()
     set_section(N_("Mouse button assignment"), NULL)
     _add_bool(DISABLE_FS_TOGGLE_CFG, DISABLE_FS_TOGGLE_DEFAULT,
               N_("Disable fullscreen toggle on double click"),
-              N_("The video will no longer fullscreen when you double click on it."), false)
+              N_("The video will no longer fullscreen when you double click on it. "
+              "Ignored in the mouse-only mode."), false)
     _add_integer(FS_TOGGLE_MOUSE_BUTTON_CFG, FS_TOGGLE_MOUSE_BUTTON_DEFAULT,
                  N_("Assign fullscreen toggle to"),
-                 N_("Assigns fullscreen toggle to a mouse button."), false)
+                 N_("Assigns fullscreen toggle to a mouse button. Ignored in the "
+                 "mouse-only mode."), false)
     change_integer_list(mouse_button_values_index, mouse_button_names)
     _add_bool(DISABLE_CONTEXT_MENU_TOGGLE_CFG, DISABLE_CONTEXT_MENU_TOGGLE_DEFAULT,
               N_("Disable context menu toggle on right click"),
               N_("The context menu will no longer pop up if you right click on the video. "
-              "Useful if you want to pause/play or full screen on right click."), false)
+              "Useful if you want to pause/play or full screen on right click. "
+              "Ignored in the mouse-only mode."), false)
     _add_integer(CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_CFG, CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_DEFAULT,
                  N_("Assign context menu toggle to"),
-                 N_("Assigns context menu toggle to a mouse button."), false)
+                 N_("Assigns context menu toggle to a mouse button. Ignored in the "
+                 "mouse-only mode."), false)
     change_integer_list(mouse_button_values_index, mouse_button_names)
+    _add_string(GESTURES_CFG, GESTURES_DEFAULT,
+                N_("Gesture bindings"),
+                N_("Comma separated bindings of mouse gestures to actions, in "
+                "the form button:gesture=action, e.g. "
+                "\"left:click=pause,left:double=fullscreen,middle:hold=speed2x\". "
+                "Buttons: left, middle, right, wheel-up, wheel-down, wheel-left, "
+                "wheel-right. Gestures: press, click, double, triple, hold. "
+                "Actions: pause, fullscreen, menu, speed2x, seek-forward, "
+                "seek-backward, volume-up, volume-down, none. The seek and volume "
+                "actions go by VLC's short jump length and volume step, and are "
+                "meant for the scroll wheel, e.g. \"wheel-up:press=volume-up\". "
+                "Clicks are told apart using the custom double click interval. "
+                "When set, it "
+                "replaces all the other options of this section, along with "
+                "VLC's own double click to fullscreen and right click menu for "
+                "the bound buttons."), false)
+    set_section(N_("Debugging"), NULL)
+    _add_bool(DEBUG_CFG, DEBUG_DEFAULT,
+              N_("Print diagnostics when a video opens"),
+              N_("Print the video format and the deinterlacing state of the "
+              "video outputs to the debug log every time the filter opens. "
+              "Off by default, as it slows down the start of every video, "
+              "but always on when VLC is run with debug verbosity, e.g. -vv."), true)
+    _add_bool(FRAME_PACING_CFG, FRAME_PACING_DEFAULT,
+              N_("Measure the pictures after a resume"),
+              N_("Measure how long it takes for the first picture to show up "
+              "after pause/play resumes the video, and how evenly the pictures "
+              "come in for a few seconds after that, to track down stutter "
+              "after unpausing. The results go to the pause-click-latency "
+              "variable of the interface and to the debug log on exit."), true)
+    _add_bool(DEFERRED_LOG_CFG, DEFERRED_LOG_DEFAULT,
+              N_("Defer formatting of debug messages"),
+              N_("Instead of formatting debug messages on the video output "
+              "thread on every mouse event, queue them up and format them on "
+              "a separate thread. On by default, as logging a message takes "
+              "longer than handling the event it's about. Messages that don't "
+              "fit in the queue are dropped."), true)
+    _add_string(TRACE_FILE_CFG, TRACE_FILE_DEFAULT,
+                N_("Mouse event trace file"),
+                N_("Record all mouse events the plugin receives into this file, "
+                "so that they can be replayed outside of VLC. Leave empty to "
+                "disable."), true)
         add_submodule()
         set_capability("interface", 0)
 #if LIBVLC_VERSION_MAJOR <= 3
@@ -225,352 +699,1742 @@ vlc_module_begin()
 vlc_module_end()
 
 
-static bool is_in_menu(void) {
-    if (!p_intf) {
-        return false;
-    }
-
-#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
-    playlist_t* p_playlist = pl_Get(p_intf);
+enum log_tag {
+    LOG_DOUBLE_CLICK,
+    LOG_PRESSED,
+    LOG_RELEASED,
+    LOG_DRAGGED,
+    LOG_MOVED,
+    LOG_MOUSE_BUTTON,
+    LOG_TIMER_CANCELLED,
+    LOG_TIMER_STARTED,
+    LOG_TIMER_EXPIRED,
+    LOG_OUT,
+    LOG_IN_MENU,
+    LOG_PAUSE_PLAY,
+    LOG_PLAYER_STATE,
+    LOG_ROLLBACK,
+};
 
-    input_title_t* p_title = NULL;
-    int i_title_id = -1;
+#define MSG "old: i_pressed=%" PRId64 ", b_double_click=%" PRId64 "; " \
+            "new: i_pressed=%" PRId64 ", b_double_click=%" PRId64
+static const char *const log_formats[] = {
+    [LOG_DOUBLE_CLICK] = "DOUBLE CLICK " MSG,
+    [LOG_PRESSED] = "PRESSED " MSG,
+    [LOG_RELEASED] = "RELEASED " MSG,
+    [LOG_DRAGGED] = "DRAGGED " MSG,
+    [LOG_MOVED] = "MOVED " MSG,
+    [LOG_MOUSE_BUTTON] = "mouse_button=%" PRId64,
+    [LOG_TIMER_CANCELLED] = "delayed click: a double click! cancelling the timer",
+    [LOG_TIMER_STARTED] = "delayed click: got a click, could it be a double-click? "
+                          "starting a timer for %" PRId64 "ms",
+    [LOG_TIMER_EXPIRED] = "delayed click: timer expired",
+    [LOG_OUT] = "out: i_pressed=%" PRId64 ", b_double_click=%" PRId64,
+    [LOG_IN_MENU] = "in a menu, not pausing/playing",
+    [LOG_PAUSE_PLAY] = "pausing/playing",
+    [LOG_PLAYER_STATE] = "player state changed: playing=%" PRId64,
+    [LOG_ROLLBACK] = "a double click! rolling back the speculative pause/play",
+};
+#undef MSG
 
-    input_thread_t* p_input = playlist_CurrentInput(p_playlist);
-    if (!p_input) {
-        return false;
-    }
-    if (input_Control(p_input, INPUT_GET_TITLE_INFO, &p_title, &i_title_id) != VLC_SUCCESS) {
-        vlc_object_release(p_input);
-        return false;
+// Logs a per-event debug message. Either formats it right away or, if the
+// deferred logging is enabled, queues the raw record up for the interface
+// thread to format.
+#ifdef DISABLE_DEBUG_LOG
+# define log_event(p_obj, p_intf_sys, tag, a, b, c, d) \
+    ((void)0)
+#else
+# define log_event(p_obj, p_intf_sys, tag, a, b, c, d) \
+    log_event_((vlc_object_t *)(p_obj), p_intf_sys, tag, a, b, c, d)
+static void log_event_(vlc_object_t *p_obj, intf_sys_t *p_intf_sys, enum log_tag tag,
+                       int64_t a, int64_t b, int64_t c, int64_t d)
+{
+    if (p_intf_sys->deferred_log) {
+        if (ring_push(&p_intf_sys->log, tag, a, b, c, d)) {
+            // a single wakeup for a burst of records
+            if (!atomic_load_explicit(&p_intf_sys->log_wakeup, memory_order_relaxed) &&
+                !atomic_exchange(&p_intf_sys->log_wakeup, true)) {
+                vlc_sem_post(&p_intf_sys->wakeup);
+            }
+        } else {
+            atomic_fetch_add(&p_intf_sys->log_dropped, 1);
+        }
+        return;
     }
-    vlc_object_release(p_input);
 
-    if (!p_title) {
-        return false;
-    }
-    if (
-#if LIBVLC_VERSION_MAJOR == 2
-        p_title->b_menu
-#elif LIBVLC_VERSION_MAJOR >= 3
-        p_title->i_flags & INPUT_TITLE_MENU || p_title->i_flags & INPUT_TITLE_INTERACTIVE
+    msg_Dbg(p_obj, log_formats[tag], a, b, c, d);
+}
 #endif
-    ) {
-        vlc_input_title_Delete(p_title);
-        return true;
-    }
 
-    vlc_input_title_Delete(p_title);
-
-    return false;
-#elif LIBVLC_VERSION_MAJOR >= 4
-    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf));
-    vlc_player_Lock(player);
-
-    const struct vlc_player_title* title = vlc_player_GetSelectedTitle(player);
-    if (!title) {
-        vlc_player_Unlock(player);
-        return false;
-    }
-    if (title->flags & VLC_PLAYER_TITLE_MENU || title->flags & VLC_PLAYER_TITLE_INTERACTIVE) {
-        vlc_player_Unlock(player);
-        return true;
+static void log_drain(intf_thread_t *intf)
+{
+    int tag;
+    int64_t args[4];
+    // the records queued from now on wake us up again
+    atomic_store(&intf->p_sys->log_wakeup, false);
+    while (ring_pop(&intf->p_sys->log, &tag, args)) {
+        msg_Dbg(intf, log_formats[tag], args[0], args[1], args[2], args[3]);
     }
 
-    vlc_player_Unlock(player);
-    return false;
-#endif
-}
-
-static int is_interlaced(void) {
-    if (!p_intf) {
-        return -1;
+    unsigned dropped = atomic_exchange(&intf->p_sys->log_dropped, 0);
+    if (dropped) {
+        msg_Dbg(intf, "%u debug messages dropped, the queue is full", dropped);
     }
+}
 
-#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
-    playlist_t* p_playlist = pl_Get(p_intf);
-
-    input_thread_t* p_input = playlist_CurrentInput(p_playlist);
-    if (!p_input) {
-        return -1;
+static unsigned histogram_index(uint64_t value)
+{
+    if (value < (1 << HISTOGRAM_SUB_BITS)) {
+        return value;
     }
+    unsigned msb = 63 - __builtin_clzll(value);
+    unsigned shift = msb - HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << HISTOGRAM_SUB_BITS) + (unsigned)(value >> shift) - (1 << HISTOGRAM_SUB_BITS);
+}
 
-    vout_thread_t** pp_vout;
-    size_t i_vout;
-    if (input_Control(p_input, INPUT_GET_VOUTS, &pp_vout, &i_vout) != VLC_SUCCESS) {
-        vlc_object_release(p_input);
-        return -1;
+// the highest value that falls into the bucket
+static uint64_t histogram_value(unsigned index)
+{
+    if (index < (1 << HISTOGRAM_SUB_BITS)) {
+        return index;
     }
+    unsigned shift = (index >> HISTOGRAM_SUB_BITS) - 1;
+    uint64_t mantissa = (index & ((1 << HISTOGRAM_SUB_BITS) - 1)) + (1 << HISTOGRAM_SUB_BITS);
+    return (mantissa << shift) + ((UINT64_C(1) << shift) - 1);
+}
 
-    int found = 0;
-    for (size_t i = 0; i < i_vout; i ++) {
-        int64_t deinterlace = var_GetInteger(pp_vout[i], "deinterlace");
-        bool deinterlace_needed = var_GetBool(pp_vout[i], "deinterlace-needed");
-        msg_Dbg(p_intf, "vout %zu/%zu: deinterlace=%" PRId64 ", deinterlace-needed=%d",
-                i, i_vout, deinterlace, deinterlace_needed);
-        if (deinterlace_needed) {
-            found = 1;
-        }
-        vlc_object_release((vlc_object_t *)pp_vout[i]);
+static void histogram_init(struct histogram *p_hist)
+{
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i ++) {
+        atomic_init(&p_hist->counts[i], 0);
     }
-    vlc_object_release(p_input);
-    free(pp_vout);
+    atomic_init(&p_hist->total, 0);
+    atomic_init(&p_hist->max, 0);
+}
 
-    return found;
-#elif LIBVLC_VERSION_MAJOR >= 4
-    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf));
-    vlc_player_Lock(player);
+static void histogram_record(struct histogram *p_hist, int64_t value)
+{
+    uint64_t v = value < 0 ? 0 : (uint64_t) value;
+    atomic_fetch_add_explicit(&p_hist->counts[histogram_index(v)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&p_hist->total, 1, memory_order_relaxed);
+    uint_least64_t max = atomic_load_explicit(&p_hist->max, memory_order_relaxed);
+    while (v > max && !atomic_compare_exchange_weak_explicit(&p_hist->max, &max, v,
+                                                             memory_order_relaxed,
+                                                             memory_order_relaxed));
+}
 
-    vout_thread_t** pp_vout;
-    size_t i_vout;
-    pp_vout = vlc_player_vout_HoldAll(player, &i_vout);
-    if (!pp_vout) {
-        vlc_player_Unlock(player);
-        return -1;
+// percentile is in the (0, 100] range
+static uint64_t histogram_percentile(struct histogram *p_hist, unsigned percentile)
+{
+    unsigned total = atomic_load_explicit(&p_hist->total, memory_order_relaxed);
+    if (total == 0) {
+        return 0;
     }
-    int found = 0;
-    for (size_t i = 0; i < i_vout; i ++) {
-        int64_t deinterlace = var_GetInteger(pp_vout[i], "deinterlace");
-        bool deinterlace_needed = var_GetBool(pp_vout[i], "deinterlace-needed");
-        msg_Dbg(p_intf, "vout %zu/%zu: deinterlace=%" PRId64 ", deinterlace-needed=%d",
-                i, i_vout, deinterlace, deinterlace_needed);
-        if (deinterlace_needed) {
-            found = 1;
+    uint64_t rank = ((uint64_t) total * percentile + 99) / 100;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i ++) {
+        seen += atomic_load_explicit(&p_hist->counts[i], memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t max = atomic_load_explicit(&p_hist->max, memory_order_relaxed);
+            uint64_t value = histogram_value(i);
+            return value < max ? value : max;
         }
-        vout_Release(pp_vout[i]);
     }
-    vlc_player_Unlock(player);
-    free(pp_vout);
-
-    return found;
-#endif
+    return atomic_load_explicit(&p_hist->max, memory_order_relaxed);
+}
 
-    return -1;
+static void counter_add_n(intf_sys_t *p_intf_sys, enum counter counter, unsigned n)
+{
+    atomic_fetch_add_explicit(&p_intf_sys->counters[counter], n, memory_order_relaxed);
 }
 
-static void display_icon(short icon) {
-    if (!p_intf) {
-        return;
-    }
+static void counter_add(intf_sys_t *p_intf_sys, enum counter counter)
+{
+    counter_add_n(p_intf_sys, counter, 1);
+}
 
-#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
-    playlist_t* p_playlist = pl_Get(p_intf);
+static unsigned counter_get(intf_sys_t *p_intf_sys, enum counter counter)
+{
+    return atomic_load_explicit(&p_intf_sys->counters[counter], memory_order_relaxed);
+}
 
-    input_thread_t* p_input = playlist_CurrentInput(p_playlist);
-    if (!p_input) {
+static void latency_record(intf_sys_t *p_intf_sys, enum latency_stage stage, int64_t start, int64_t end)
+{
+    if (start == 0) {
         return;
     }
+    histogram_record(&p_intf_sys->latency[stage], end - start);
+    atomic_store(&p_intf_sys->latency_updated, true);
+}
 
-    vout_thread_t** pp_vout;
-    size_t i_vout;
-    if (input_Control(p_input, INPUT_GET_VOUTS, &pp_vout, &i_vout) != VLC_SUCCESS) {
-        vlc_object_release(p_input);
-        return;
+// formats all the latency histograms into the buffer, one stage per line
+static void latency_format(intf_thread_t *intf, char *buf, size_t size)
+{
+    size_t len = 0;
+    buf[0] = '\0';
+    for (unsigned i = 0; i < LATENCY_STAGES && len < size; i ++) {
+        struct histogram *p_hist = &intf->p_sys->latency[i];
+        int n = snprintf(buf + len, size - len,
+                         "%s: n=%u p50=%" PRIu64 "us p99=%" PRIu64 "us max=%" PRIu64 "us\n",
+                         latency_stage_names[i], atomic_load(&p_hist->total),
+                         histogram_percentile(p_hist, 50), histogram_percentile(p_hist, 99),
+                         (uint64_t) atomic_load(&p_hist->max));
+        if (n < 0) {
+            break;
+        }
+        len += n;
     }
-    for (size_t i = 0; i < i_vout; i ++) {
-        vout_OSDIcon(pp_vout[i],
-#if LIBVLC_VERSION_MAJOR == 2
-                     SPU_DEFAULT_CHANNEL,
-#elif LIBVLC_VERSION_MAJOR >= 3
-                     VOUT_SPU_CHANNEL_OSD,
-#endif
-                     icon);
-        vlc_object_release((vlc_object_t *)pp_vout[i]);
+    if (len < size) {
+        snprintf(buf + len, size - len, "speculative: n=%u rolled back=%u\n",
+                 counter_get(intf->p_sys, COUNTER_SPECULATIONS), counter_get(intf->p_sys, COUNTER_ROLLBACKS));
     }
-    vlc_object_release(p_input);
-    free(pp_vout);
-#elif LIBVLC_VERSION_MAJOR >= 4
-    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf));
-    vlc_player_Lock(player);
+}
 
-    vout_thread_t** pp_vout;
-    size_t i_vout;
-    pp_vout = vlc_player_vout_HoldAll(player, &i_vout);
-    if (!pp_vout) {
-        vlc_player_Unlock(player);
+static void latency_publish(intf_thread_t *intf)
+{
+    if (!atomic_exchange(&intf->p_sys->latency_updated, false)) {
         return;
     }
-    for (size_t i = 0; i < i_vout; i ++) {
-        vout_OSDIcon(pp_vout[i], VOUT_SPU_CHANNEL_OSD, icon);
-        vout_Release(pp_vout[i]);
-    }
-
-    vlc_player_Unlock(player);
-    free(pp_vout);
-#endif
+    char buf[2048];
+    latency_format(intf, buf, sizeof(buf));
+    var_SetString(intf, LATENCY_VAR, buf);
 }
 
-static void pause_play(void)
+// The counter variables are snapshots of the counters, brought up to date by
+// the interface thread after its commands and every COUNTERS_PERIOD while
+// there are vouts, so they might lag behind by up to that much.
+static void counters_publish(intf_thread_t *intf)
 {
-    if (!p_intf) {
-        return;
+    intf_sys_t *p_sys = intf->p_sys;
+    for (unsigned i = 0; i < COUNTERS; i ++) {
+        unsigned value = counter_get(p_sys, i);
+        if (value != atomic_load_explicit(&p_sys->counters_published[i], memory_order_relaxed)) {
+            // stored first, so that the callback tells our write apart
+            atomic_store(&p_sys->counters_published[i], value);
+            var_SetInteger(intf, counter_names[i], value);
+        }
     }
+}
 
-    if (is_in_menu()) {
-        msg_Dbg(p_intf, "in a menu, not pausing/playing");
-        return;
+// The counters are read-only: a value written from outside, e.g. from the Lua
+// or RC interface, is rejected.
+static int counter_var_callback(vlc_object_t *p_this, char const *psz_var,
+                                vlc_value_t oldval, vlc_value_t newval, void *p_data)
+{
+    UNUSED(p_this);
+    UNUSED(oldval);
+
+    intf_sys_t *p_sys = (intf_sys_t *) p_data;
+    for (unsigned i = 0; i < COUNTERS; i ++) {
+        if (strcmp(psz_var, counter_names[i]) == 0) {
+            if (newval.i_int != atomic_load(&p_sys->counters_published[i])) {
+                return VLC_EGENERIC;
+            }
+            break;
+        }
     }
 
-    msg_Dbg(p_intf, "pausing/playing");
+    return VLC_SUCCESS;
+}
 
-#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
-    playlist_t* p_playlist = pl_Get(p_intf);
-    playlist_status_t status = playlist_Status(p_playlist);
-    playlist_Control(p_playlist, status == PLAYLIST_RUNNING ? PLAYLIST_PAUSE : PLAYLIST_PLAY , 0);
-    if (var_InheritBool(p_intf, DISPLAY_ICON_CFG)) {
-        display_icon(status == PLAYLIST_RUNNING ? OSD_PAUSE_ICON : OSD_PLAY_ICON);
-    }
-#elif LIBVLC_VERSION_MAJOR >= 4
-    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(p_intf));
-    vlc_player_Lock(player);
-    int state = vlc_player_GetState(player);
-    state == VLC_PLAYER_STATE_PLAYING ? vlc_player_Pause(player) : vlc_player_Resume(player);
-    vlc_player_Unlock(player);
-    if (var_InheritBool(p_intf, DISPLAY_ICON_CFG)) {
-        display_icon(state == VLC_PLAYER_STATE_PLAYING ? OSD_PAUSE_ICON : OSD_PLAY_ICON);
+static void counters_create(intf_thread_t *intf, intf_sys_t *p_sys)
+{
+    for (unsigned i = 0; i < COUNTERS; i ++) {
+        atomic_init(&p_sys->counters[i], 0);
+        atomic_init(&p_sys->counters_published[i], 0);
+        var_Create(intf, counter_names[i], VLC_VAR_INTEGER);
+        var_AddCallback(intf, counter_names[i], counter_var_callback, p_sys);
     }
-#endif
+    atomic_init(&p_sys->counters_active, false);
 }
 
-static void timer_callback(void* data)
+static void counters_destroy(intf_thread_t *intf)
 {
-    if (!atomic_load(&timer_scheduled)) {
-        return;
+    for (unsigned i = 0; i < COUNTERS; i ++) {
+        var_DelCallback(intf, counter_names[i], counter_var_callback, intf->p_sys);
+        var_Destroy(intf, counter_names[i]);
     }
+}
 
-    filter_t *p_filter = (filter_t *) data;
-    msg_Dbg(p_filter, "delayed click: timer expired");
-    if (var_InheritBool(p_filter, IGNORE_DOUBLE_CLICK_CFG)) {
-        pause_play();
+static void counters_timer_callback(void *data)
+{
+    intf_sys_t *p_sys = (intf_sys_t *) data;
+    vlc_sem_post(&p_sys->wakeup);
+    if (atomic_load(&p_sys->counters_active)) {
+        timer_wheel_schedule(p_sys->wheel, &p_sys->counters_timer, _now_us() + COUNTERS_PERIOD);
     }
-
-    atomic_store(&timer_scheduled, false);
 }
 
-static int cfg_get_mouse_button(vlc_object_t *p_obj, const char *cfg, int default_value) {
-    int mouse_button = mouse_button_values[default_value];
-    int mouse_button_index = var_InheritInteger(p_obj, cfg);
-    if (mouse_button_index >= 0 && (size_t)mouse_button_index <= sizeof(mouse_button_values)-1) {
-        mouse_button = mouse_button_values[mouse_button_index];
+// Runs the periodic publishing only while there are vouts: without them the
+// counters only change along with the commands, which publish them anyway.
+static void counters_watch(intf_sys_t *p_sys, bool active)
+{
+    if (!p_sys->wheel || atomic_exchange(&p_sys->counters_active, active) == active) {
+        return;
+    }
+    if (active) {
+        timer_wheel_schedule(p_sys->wheel, &p_sys->counters_timer, _now_us() + COUNTERS_PERIOD);
+    } else {
+        // also drops the rescheduling of a running callback
+        timer_wheel_cancel(p_sys->wheel, &p_sys->counters_timer);
     }
-    return mouse_button;
 }
 
-static int mouse(filter_t *p_filter, vlc_mouse_t *p_mouse_out, const vlc_mouse_t *p_mouse_old, const vlc_mouse_t *p_mouse_new)
+static void vouts_release(vout_thread_t **pp_vout, size_t i_vout)
 {
-    *p_mouse_out = *p_mouse_new;
-
-    // we don't want to process anything if no mouse button is pressed
-    if (p_mouse_new->i_pressed == 0 && !p_mouse_new->b_double_click) {
-        return VLC_SUCCESS;
+    for (size_t i = 0; i < i_vout; i ++) {
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+        vlc_object_release((vlc_object_t *)pp_vout[i]);
+#elif LIBVLC_VERSION_MAJOR >= 4
+        vout_Release(pp_vout[i]);
+#endif
     }
+    free(pp_vout);
+}
 
-#define MSG "old: i_pressed=%d, b_double_click=%d; " \
-            "new: i_pressed=%d, b_double_click=%d", \
-            p_mouse_old->i_pressed, p_mouse_old->b_double_click, \
-            p_mouse_new->i_pressed, p_mouse_new->b_double_click
-    if (p_mouse_new->b_double_click) {
-        msg_Dbg(p_filter, "DOUBLE CLICK " MSG);
-    } else if (p_mouse_old->i_pressed < p_mouse_new->i_pressed) {
-        msg_Dbg(p_filter, "PRESSED " MSG);
-    } else if (p_mouse_old->i_pressed > p_mouse_new->i_pressed) {
-        msg_Dbg(p_filter, "RELEASED " MSG);
-    } else if (p_mouse_old->i_pressed == p_mouse_new->i_pressed) {
-        if (p_mouse_old->i_pressed != 0) {
-            msg_Dbg(p_filter, "DRAGGED " MSG);
-        } else {
-            msg_Dbg(p_filter, "MOVED " MSG);
-        }
-    }
-#undef MSG
+static int vout_mouse_callback(vlc_object_t *, char const *, vlc_value_t, vlc_value_t, void *);
 
-    // get mouse button from settings. updates if user changes the setting
-    const int mouse_button = cfg_get_mouse_button((vlc_object_t *)p_filter, MOUSE_BUTTON_CFG, MOUSE_BUTTON_DEFAULT);
-    msg_Dbg(p_filter, "mouse_button=%d", mouse_button);
+// whether the vout has the mouse variable the mouse-only mode watches. A vout
+// that doesn't is left to the video filter
+static bool vout_has_mouse_var(vlc_object_t *p_vout)
+{
+    return (var_Type(p_vout, "mouse-button-down") & VLC_VAR_CLASS) == VLC_VAR_INTEGER;
+}
 
-    // manually control double click to fullscreen if directly requested or if the ignore double click option is set
-    if ((var_InheritBool(p_filter, ENABLE_DOUBLE_CLICK_DELAY_CFG) || var_InheritBool(p_filter, IGNORE_DOUBLE_CLICK_CFG)) &&
-            mouse_button == MOUSE_BUTTON_LEFT) {
-        msg_Dbg(p_filter, "manually controlling double click");
-        p_mouse_out->b_double_click = 0;
+// in the mouse-only mode, starts or stops watching the mouse of the vouts
+static void vouts_hook(intf_thread_t *intf, vout_thread_t **pp_vout, size_t i_vout, bool hook)
+{
+    struct filter_sys_t *p_state = intf->p_sys->mouse_only;
+    if (!p_state) {
+        return;
     }
 
-    // react only on the configured mouse button click
-    if (vlc_mouse_HasPressed(p_mouse_old, p_mouse_new, mouse_button)
-#if LIBVLC_VERSION_MAJOR <= 3
-            // treat the double click as the left mouse button click
-            || (p_mouse_new->b_double_click && mouse_button == MOUSE_BUTTON_LEFT)
-#endif
-            ) {
-        // pause/play on every click unless told not to
-        if (!var_InheritBool(p_filter, IGNORE_DOUBLE_CLICK_CFG)) {
-            pause_play();
-        }
-        // do the double click logic
-        if ((var_InheritBool(p_filter, IGNORE_DOUBLE_CLICK_CFG) || var_InheritBool(p_filter, ENABLE_DOUBLE_CLICK_DELAY_CFG)) &&
-                mouse_button == MOUSE_BUTTON_LEFT && timer_initialized) {
-            if (atomic_load(&timer_scheduled)) {
-                // it's a double click -- cancel the scheduled timer
-                atomic_store(&timer_scheduled, false);
-                vlc_timer_schedule(timer, false, 0, 0);
-                // and set fullscreen
-                p_mouse_out->b_double_click = 1;
-                msg_Dbg(p_filter, "delayed click: a double click! cancelling the timer");
-            } else {
-                // it might be a single click -- schedule a timer
-                atomic_store(&timer_scheduled, true);
-                int64_t delay = var_InheritInteger(p_filter, DOUBLE_CLICK_DELAY_CFG);
-                vlc_timer_schedule(timer, false, delay*1000, 0);
-                msg_Dbg(p_filter, "delayed click: got a click, could it be a double-click? starting a timer for %" PRId64 "ms", delay);
+    for (size_t i = 0; i < i_vout; i ++) {
+        if (!vout_has_mouse_var(VLC_OBJECT(pp_vout[i]))) {
+            if (hook) {
+                msg_Warn(intf, "the video output has no mouse button variable to watch, "
+                         "enable the video filter for its clicks");
             }
+            continue;
+        }
+        if (hook) {
+            var_AddCallback(pp_vout[i], "mouse-button-down", vout_mouse_callback, p_state);
+        } else {
+            // waits for the callback to return
+            var_DelCallback(pp_vout[i], "mouse-button-down", vout_mouse_callback, p_state);
         }
     }
+}
 
-    // prevent fullscreen from toggling on double click
-    if (var_InheritBool(p_filter, DISABLE_FS_TOGGLE_CFG) &&
-            (p_mouse_new->b_double_click || p_mouse_out->b_double_click)) {
-        p_mouse_out->b_double_click = 0;
-    }
-
-    // toggle fullscreen on specified mouse click
-    const int fs_mouse_button = cfg_get_mouse_button((vlc_object_t *)p_filter, FS_TOGGLE_MOUSE_BUTTON_CFG,
-                                                     FS_TOGGLE_MOUSE_BUTTON_DEFAULT);
-    if (fs_mouse_button != -1 && vlc_mouse_HasPressed(p_mouse_old, p_mouse_new, fs_mouse_button)) {
-#if LIBVLC_VERSION_MAJOR >= 4
-        vlc_mouse_SetPressed(p_mouse_out, MOUSE_BUTTON_LEFT);
-#endif
-        p_mouse_out->b_double_click = 1;
-    }
+// replaces the registered vouts with the given held ones, taking over the
+// array
+static void vouts_replace(intf_thread_t *intf, vout_thread_t **pp_vout, size_t i_vout)
+{
+    intf_sys_t *p_sys = intf->p_sys;
 
-    // prevent the context menu from toggling on right click
-    if (var_InheritBool(p_filter, DISABLE_CONTEXT_MENU_TOGGLE_CFG) &&
-            vlc_mouse_IsPressed(p_mouse_new, MOUSE_BUTTON_RIGHT)) {
-        p_mouse_out->i_pressed = 0;
-    }
+    vouts_hook(intf, pp_vout, i_vout, true);
 
-    // toggle context menu on specified mouse click
-    const int context_menu_mouse_button =
-            cfg_get_mouse_button((vlc_object_t *)p_filter,CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_CFG,
-                                 CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_DEFAULT);
-    if (context_menu_mouse_button != -1 &&
-            vlc_mouse_HasPressed(p_mouse_old, p_mouse_new, context_menu_mouse_button)) {
-        vlc_mouse_SetPressed(p_mouse_out, MOUSE_BUTTON_RIGHT);
-    }
+    vlc_mutex_lock(&p_sys->vouts_lock);
+    vout_thread_t **pp_old = p_sys->vouts;
+    size_t i_old = p_sys->vouts_count;
+    p_sys->vouts = pp_vout;
+    p_sys->vouts_count = i_vout;
+    p_sys->vouts_capacity = i_vout;
+    vlc_mutex_unlock(&p_sys->vouts_lock);
 
-    msg_Dbg(p_filter, "out: i_pressed=%d, b_double_click=%d", p_mouse_out->i_pressed, p_mouse_out->b_double_click);
+    counters_watch(p_sys, i_vout > 0);
 
-    return VLC_SUCCESS;
+    // releasing a vout might destroy it, so don't do that with the lock held
+    vouts_hook(intf, pp_old, i_old, false);
+    vouts_release(pp_old, i_old);
 }
 
-static picture_t *filter(filter_t *p_filter, picture_t *p_pic_in)
+static void player_state_changed(intf_thread_t *intf, bool playing)
 {
-    UNUSED(p_filter);
+    log_event(intf, intf->p_sys, LOG_PLAYER_STATE, playing, 0, 0, 0);
 
-    // don't alter picture
-    return p_pic_in;
-}
+    int64_t click_time = atomic_exchange(&intf->p_sys->observed_click_time, 0);
+    latency_record(intf->p_sys, LATENCY_CLICK_TO_OBSERVED, click_time, _now_us());
 
-#if LIBVLC_VERSION_MAJOR >= 4
+    // the vout has stopped on whatever picture it was on by now
+    if (!playing && atomic_load(&intf->p_sys->pause_vout)) {
+        if (ring_push(&intf->p_sys->commands, COMMAND_FRAME_SEEK, 0, 0, 0, 0)) {
+            vlc_sem_post(&intf->p_sys->wakeup);
+        } else {
+            counter_add(intf->p_sys, COUNTER_COMMANDS_DROPPED);
+        }
+    }
+}
+
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+// allocates, so it's called only on the input's title changes
+static bool input_is_in_menu(input_thread_t *p_input)
+{
+    input_title_t* p_title = NULL;
+    int i_title_id = -1;
+
+    if (input_Control(p_input, INPUT_GET_TITLE_INFO, &p_title, &i_title_id) != VLC_SUCCESS) {
+        return false;
+    }
+
+    if (!p_title) {
+        return false;
+    }
+    if (
+#if LIBVLC_VERSION_MAJOR == 2
+        p_title->b_menu
+#elif LIBVLC_VERSION_MAJOR >= 3
+        p_title->i_flags & INPUT_TITLE_MENU || p_title->i_flags & INPUT_TITLE_INTERACTIVE
+#endif
+    ) {
+        vlc_input_title_Delete(p_title);
+        return true;
+    }
+
+    vlc_input_title_Delete(p_title);
+
+    return false;
+}
+
+static bool input_is_playing(input_thread_t *p_input)
+{
+    int64_t state = var_GetInteger(p_input, "state");
+    return state == INIT_S || state == OPENING_S || state == PLAYING_S;
+}
+
+// allocates, so it's called only on the input's vout changes
+static void vouts_refresh(intf_thread_t *intf, input_thread_t *p_input)
+{
+    vout_thread_t** pp_vout;
+    size_t i_vout;
+    if (input_Control(p_input, INPUT_GET_VOUTS, &pp_vout, &i_vout) != VLC_SUCCESS) {
+        pp_vout = NULL;
+        i_vout = 0;
+    }
+    vouts_replace(intf, pp_vout, i_vout);
+}
+
+static int input_event_callback(vlc_object_t *p_this, char const *psz_var,
+                                vlc_value_t oldval, vlc_value_t newval, void *p_data)
+{
+    UNUSED(psz_var);
+    UNUSED(oldval);
+
+    intf_thread_t *intf = (intf_thread_t *) p_data;
+    input_thread_t *p_input = (input_thread_t *) p_this;
+
+    switch (newval.i_int) {
+        case INPUT_EVENT_STATE:
+            player_state_changed(intf, input_is_playing(p_input));
+            break;
+        case INPUT_EVENT_TITLE:
+            atomic_store(&intf->p_sys->in_menu, input_is_in_menu(p_input));
+            break;
+        case INPUT_EVENT_VOUT:
+            vouts_refresh(intf, p_input);
+            break;
+    }
+
+    return VLC_SUCCESS;
+}
+
+// follows the given input's events instead of the current one's. takes over
+// the reference to p_input
+static void input_attach(intf_thread_t *intf, input_thread_t *p_input)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+
+    vlc_mutex_lock(&p_sys->input_lock);
+    input_thread_t *p_old = p_sys->input;
+    p_sys->input = p_input;
+    vlc_mutex_unlock(&p_sys->input_lock);
+    atomic_fetch_add(&p_sys->input_changes, 1);
+
+    if (p_old) {
+        var_DelCallback(p_old, "intf-event", input_event_callback, intf);
+        vlc_object_release(p_old);
+    }
+
+    if (p_input) {
+        var_AddCallback(p_input, "intf-event", input_event_callback, intf);
+        atomic_store(&p_sys->in_menu, input_is_in_menu(p_input));
+        vouts_refresh(intf, p_input);
+    } else {
+        atomic_store(&p_sys->in_menu, false);
+        vouts_replace(intf, NULL, 0);
+    }
+}
+
+static int input_current_callback(vlc_object_t *p_this, char const *psz_var,
+                                  vlc_value_t oldval, vlc_value_t newval, void *p_data)
+{
+    UNUSED(p_this);
+    UNUSED(psz_var);
+    UNUSED(oldval);
+
+    input_thread_t *p_input = (input_thread_t *) newval.p_address;
+    if (p_input) {
+        vlc_object_hold(p_input);
+    }
+    input_attach((intf_thread_t *) p_data, p_input);
+
+    return VLC_SUCCESS;
+}
+
+static void player_watch_init(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+    playlist_t* p_playlist = pl_Get(intf);
+
+    vlc_mutex_init(&p_sys->input_lock);
+    p_sys->input = NULL;
+    var_AddCallback(p_playlist, "input-current", input_current_callback, intf);
+    input_attach(intf, playlist_CurrentInput(p_playlist));
+}
+
+static void player_watch_destroy(intf_thread_t *intf)
+{
+    var_DelCallback(pl_Get(intf), "input-current", input_current_callback, intf);
+    input_attach(intf, NULL);
+    _vlc_mutex_destroy(&intf->p_sys->input_lock);
+}
+#elif LIBVLC_VERSION_MAJOR >= 4
+static bool title_is_menu(const struct vlc_player_title *title)
+{
+    return title && (title->flags & VLC_PLAYER_TITLE_MENU || title->flags & VLC_PLAYER_TITLE_INTERACTIVE);
+}
+
+static bool state_is_playing(enum vlc_player_state state)
+{
+    return state == VLC_PLAYER_STATE_STARTED || state == VLC_PLAYER_STATE_PLAYING;
+}
+
+static void player_on_state_changed(vlc_player_t *player, enum vlc_player_state new_state, void *data)
+{
+    UNUSED(player);
+
+    player_state_changed((intf_thread_t *) data, state_is_playing(new_state));
+}
+
+static void player_on_current_media_changed(vlc_player_t *player, input_item_t *new_media, void *data)
+{
+    UNUSED(player);
+    UNUSED(new_media);
+
+    atomic_fetch_add(&((intf_thread_t *) data)->p_sys->input_changes, 1);
+}
+
+static void player_on_vout_changed(vlc_player_t *player, enum vlc_player_vout_action action,
+                                   vout_thread_t *vout, enum vlc_vout_order order,
+                                   vlc_es_id_t *es_id, void *data)
+{
+    UNUSED(player);
+    UNUSED(order);
+    UNUSED(es_id);
+
+    intf_thread_t *intf = (intf_thread_t *) data;
+    intf_sys_t *p_sys = intf->p_sys;
+
+    vlc_mutex_lock(&p_sys->vouts_lock);
+    if (action == VLC_PLAYER_VOUT_STARTED) {
+        if (p_sys->vouts_count == p_sys->vouts_capacity) {
+            size_t capacity = p_sys->vouts_capacity ? p_sys->vouts_capacity * 2 : 4;
+            vout_thread_t **pp_vout = realloc(p_sys->vouts, capacity * sizeof(*pp_vout));
+            if (!pp_vout) {
+                vlc_mutex_unlock(&p_sys->vouts_lock);
+                return;
+            }
+            p_sys->vouts = pp_vout;
+            p_sys->vouts_capacity = capacity;
+        }
+        p_sys->vouts[p_sys->vouts_count++] = vout_Hold(vout);
+        vlc_mutex_unlock(&p_sys->vouts_lock);
+        vouts_hook(intf, &vout, 1, true);
+        counters_watch(p_sys, true);
+    } else {
+        bool found = false;
+        for (size_t i = 0; i < p_sys->vouts_count; i ++) {
+            if (p_sys->vouts[i] == vout) {
+                p_sys->vouts[i] = p_sys->vouts[--p_sys->vouts_count];
+                found = true;
+                break;
+            }
+        }
+        const bool active = p_sys->vouts_count > 0;
+        vlc_mutex_unlock(&p_sys->vouts_lock);
+        counters_watch(p_sys, active);
+        if (found) {
+            vouts_hook(intf, &vout, 1, false);
+            vout_Release(vout);
+        }
+    }
+}
+
+static const struct vlc_player_cbs player_cbs = {
+    .on_current_media_changed = player_on_current_media_changed,
+    .on_state_changed = player_on_state_changed,
+    .on_vout_changed = player_on_vout_changed,
+};
+
+static void player_watch_init(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+
+    vlc_player_Lock(player);
+    p_sys->player_listener = vlc_player_AddListener(player, &player_cbs, intf);
+    size_t i_vout;
+    vout_thread_t **pp_vout = vlc_player_vout_HoldAll(player, &i_vout);
+    vouts_replace(intf, pp_vout, pp_vout ? i_vout : 0);
+    vlc_player_Unlock(player);
+}
+
+static void player_watch_destroy(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+
+    if (p_sys->player_listener) {
+        vlc_player_Lock(player);
+        vlc_player_RemoveListener(player, p_sys->player_listener);
+        vlc_player_Unlock(player);
+    }
+    vouts_replace(intf, NULL, 0);
+}
+#endif
+
+static int is_interlaced(vlc_object_t *p_obj, intf_sys_t *p_sys) {
+    vlc_mutex_lock(&p_sys->vouts_lock);
+    int found = 0;
+    for (size_t i = 0; i < p_sys->vouts_count; i ++) {
+        int64_t deinterlace = var_GetInteger(p_sys->vouts[i], "deinterlace");
+        bool deinterlace_needed = var_GetBool(p_sys->vouts[i], "deinterlace-needed");
+        msg_Dbg(p_obj, "vout %zu/%zu: deinterlace=%" PRId64 ", deinterlace-needed=%d",
+                i, p_sys->vouts_count, deinterlace, deinterlace_needed);
+        if (deinterlace_needed) {
+            found = 1;
+        }
+    }
+    vlc_mutex_unlock(&p_sys->vouts_lock);
+
+    return found;
+}
+
+static unsigned pause_play_flags(const struct config *cfg, bool speculative)
+{
+    return (speculative ? PAUSE_PLAY_SPECULATIVE : 0) |
+           (cfg->display_icon ? PAUSE_PLAY_ICON : 0) |
+           (cfg->display_icon_on_all_vouts ? PAUSE_PLAY_ICON_ALL_VOUTS : 0);
+}
+
+// Displays the icon on the vout, if it's still one of the held ones, or on
+// all of them if p_vout is NULL. Only one OSD is created for a vout however
+// many vouts there are.
+static void display_icon(intf_sys_t *p_sys, short icon, vlc_object_t *p_vout) {
+    counter_add(p_sys, COUNTER_VOUT_ENUMERATIONS);
+    vlc_mutex_lock(&p_sys->vouts_lock);
+    for (size_t i = 0; i < p_sys->vouts_count; i ++) {
+        if (p_vout && VLC_OBJECT(p_sys->vouts[i]) != p_vout) {
+            continue;
+        }
+        vout_OSDIcon(p_sys->vouts[i],
+#if LIBVLC_VERSION_MAJOR == 2
+                     SPU_DEFAULT_CHANNEL,
+#elif LIBVLC_VERSION_MAJOR >= 3
+                     VOUT_SPU_CHANNEL_OSD,
+#endif
+                     icon);
+    }
+    vlc_mutex_unlock(&p_sys->vouts_lock);
+}
+
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+// returns the current input held, or NULL
+static input_thread_t *input_hold(intf_thread_t *intf)
+{
+    vlc_mutex_lock(&intf->p_sys->input_lock);
+    input_thread_t *p_input = intf->p_sys->input;
+    if (p_input) {
+        vlc_object_hold(p_input);
+    }
+    vlc_mutex_unlock(&intf->p_sys->input_lock);
+
+    return p_input;
+}
+#endif
+
+static void player_set_playing(intf_thread_t *intf, bool play)
+{
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    playlist_t* p_playlist = pl_Get(intf);
+    playlist_Control(p_playlist, play ? PLAYLIST_PLAY : PLAYLIST_PAUSE , 0);
+#elif LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+    vlc_player_Lock(player);
+    play ? vlc_player_Resume(player) : vlc_player_Pause(player);
+    vlc_player_Unlock(player);
+#endif
+}
+
+// what the player was like when pause/play was toggled
+struct toggle {
+    bool in_menu;
+    bool playing;
+    // the media time in microseconds, -1 if unknown or not asked for
+    int64_t time;
+};
+
+// Checks for a menu and toggles pause/play in one go, so that the player
+// can't change in between: in one critical section on VLC 4, with one
+// reference to the input on VLC 2 and 3. Nothing is toggled in a menu.
+static void player_toggle(intf_thread_t *intf, bool get_time, struct toggle *p_toggle)
+{
+    p_toggle->time = -1;
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    // asking the input for the title allocates, in_menu is kept up to date
+    // by the input's title events instead
+    p_toggle->in_menu = atomic_load(&intf->p_sys->in_menu);
+    input_thread_t *p_input = input_hold(intf);
+    if (!p_input) {
+        p_toggle->playing = false;
+        if (!p_toggle->in_menu) {
+            playlist_Control(pl_Get(intf), PLAYLIST_PLAY, 0);
+        }
+        return;
+    }
+    p_toggle->playing = input_is_playing(p_input);
+    if (!p_toggle->in_menu) {
+        if (get_time) {
+            p_toggle->time = var_GetInteger(p_input, "time");
+        }
+        // through the playlist, so that its status, which the UI and the
+        // hotkeys go by, follows. the held input keeps the time consistent
+        // with the state we have toggled from
+        playlist_Control(pl_Get(intf), p_toggle->playing ? PLAYLIST_PAUSE : PLAYLIST_PLAY, 0);
+    }
+    vlc_object_release(p_input);
+#elif LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+    vlc_player_Lock(player);
+    p_toggle->in_menu = title_is_menu(vlc_player_GetSelectedTitle(player));
+    p_toggle->playing = state_is_playing(vlc_player_GetState(player));
+    if (!p_toggle->in_menu) {
+        if (get_time) {
+            vlc_tick_t time = vlc_player_GetTime(player);
+            p_toggle->time = time == VLC_TICK_INVALID ? -1 : US_FROM_VLC_TICK(time);
+        }
+        p_toggle->playing ? vlc_player_Pause(player) : vlc_player_Resume(player);
+    }
+    vlc_player_Unlock(player);
+#endif
+}
+
+// the media time in microseconds, -1 if nothing is playing
+static int64_t player_get_time(intf_thread_t *intf)
+{
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    input_thread_t *p_input = input_hold(intf);
+    if (!p_input) {
+        return -1;
+    }
+    int64_t time = var_GetInteger(p_input, "time");
+    vlc_object_release(p_input);
+    return time;
+#elif LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+    vlc_player_Lock(player);
+    vlc_tick_t time = vlc_player_GetTime(player);
+    vlc_player_Unlock(player);
+    return time == VLC_TICK_INVALID ? -1 : US_FROM_VLC_TICK(time);
+#endif
+}
+
+static float player_get_rate(intf_thread_t *intf)
+{
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    return var_GetFloat(pl_Get(intf), "rate");
+#elif LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+    vlc_player_Lock(player);
+    float rate = vlc_player_GetRate(player);
+    vlc_player_Unlock(player);
+    return rate;
+#endif
+}
+
+static void player_set_rate(intf_thread_t *intf, float rate)
+{
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    var_SetFloat(pl_Get(intf), "rate", rate);
+#elif LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+    vlc_player_Lock(player);
+    vlc_player_ChangeRate(player, rate);
+    vlc_player_Unlock(player);
+#endif
+}
+
+// a fast seek by as many of VLC's short jumps, backward if negative
+static void player_jump(intf_thread_t *intf, int jumps)
+{
+    const int64_t offset = jumps * var_InheritInteger(intf, "short-jump-size") * INT64_C(1000000);
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    input_thread_t *p_input = input_hold(intf);
+    if (!p_input) {
+        return;
+    }
+#if LIBVLC_VERSION_MAJOR == 2
+    var_SetTime(p_input, "time-offset", offset);
+#else
+    var_SetInteger(p_input, "time-offset", offset);
+#endif
+    vlc_object_release(p_input);
+#elif LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+    vlc_player_Lock(player);
+    vlc_player_SeekByTime(player, VLC_TICK_FROM_US(offset), VLC_PLAYER_SEEK_FAST,
+                          VLC_PLAYER_WHENCE_RELATIVE);
+    vlc_player_Unlock(player);
+#endif
+}
+
+// by as many of VLC's volume steps, down if negative
+static void player_change_volume(intf_thread_t *intf, int steps)
+{
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    playlist_VolumeUp(pl_Get(intf), steps, NULL);
+#elif LIBVLC_VERSION_MAJOR >= 4
+    // the audio output functions don't take the player lock
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+    vlc_player_aout_IncrementVolume(player, steps, NULL);
+#endif
+}
+
+// a precise seek, not a fast one
+static void player_seek(intf_thread_t *intf, int64_t time)
+{
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    input_thread_t *p_input = input_hold(intf);
+    if (!p_input) {
+        return;
+    }
+#if LIBVLC_VERSION_MAJOR == 2
+    input_Control(p_input, INPUT_SET_TIME, time);
+#else
+    input_Control(p_input, INPUT_SET_TIME, time, false);
+#endif
+    vlc_object_release(p_input);
+#elif LIBVLC_VERSION_MAJOR >= 4
+    vlc_player_t* player = vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf));
+    vlc_player_Lock(player);
+    vlc_player_SeekByTime(player, VLC_TICK_FROM_US(time), VLC_PLAYER_SEEK_PRECISE,
+                          VLC_PLAYER_WHENCE_ABSOLUTE);
+    vlc_player_Unlock(player);
+#endif
+}
+
+static void filters_add(intf_sys_t *p_sys, struct filter_sys_t *p_filter)
+{
+    vlc_mutex_lock(&p_sys->vouts_lock);
+    p_filter->p_next_open = p_sys->filters;
+    p_sys->filters = p_filter;
+    vlc_mutex_unlock(&p_sys->vouts_lock);
+}
+
+static void filters_remove(intf_sys_t *p_sys, struct filter_sys_t *p_filter)
+{
+    vlc_mutex_lock(&p_sys->vouts_lock);
+    for (struct filter_sys_t **pp = &p_sys->filters; *pp; pp = &(*pp)->p_next_open) {
+        if (*pp == p_filter) {
+            *pp = p_filter->p_next_open;
+            break;
+        }
+    }
+    vlc_mutex_unlock(&p_sys->vouts_lock);
+}
+
+// the open filter of the vout, NULL if none. must be called with vouts_lock
+// held
+static struct filter_sys_t *filters_find(intf_sys_t *p_sys, vlc_object_t *p_vout)
+{
+    for (struct filter_sys_t *p_filter = p_sys->filters; p_filter; p_filter = p_filter->p_next_open) {
+        if (p_filter->vout == p_vout) {
+            return p_filter;
+        }
+    }
+    return NULL;
+}
+
+// Remembers the clicked picture in the filter of the vout, so that
+// frame_seek() goes back to it in that vout's pictures. Returns false if the
+// vout has no open filter.
+static bool filters_set_pause_frame(intf_sys_t *p_sys, vlc_object_t *p_vout, int64_t frame_date)
+{
+    vlc_mutex_lock(&p_sys->vouts_lock);
+    struct filter_sys_t *p_filter = filters_find(p_sys, p_vout);
+    if (p_filter) {
+        atomic_store(&p_filter->pause_frame_date, frame_date);
+    }
+    vlc_mutex_unlock(&p_sys->vouts_lock);
+    return p_filter != NULL;
+}
+
+// Runs on the interface thread. click_time is the time of the mouse event that
+// has triggered the pause/play, frame_date is the date of the picture to pause
+// on or 0 in the pictures of p_vout, the clicked vout or NULL, and flags are
+// enum pause_play_flag. A speculative pause/play remembers the player for a
+// rollback. Doesn't allocate: the vouts come from the registry the player
+// events keep up to date
+static void pause_play(intf_thread_t *intf, int64_t click_time, vlc_object_t *p_vout,
+                       int64_t frame_date, unsigned flags)
+{
+    const bool speculative = flags & PAUSE_PLAY_SPECULATIVE;
+    intf_sys_t *p_sys = intf->p_sys;
+
+    latency_record(p_sys, LATENCY_CLICK_TO_DISPATCH, click_time, _now_us());
+
+    p_sys->rollback.valid = false;
+
+    // set before the toggle, as the player might report the pause before
+    // player_toggle() returns
+    const bool seek = frame_date && p_vout && filters_set_pause_frame(p_sys, p_vout, frame_date);
+    atomic_store(&p_sys->pause_vout, seek ? (uintptr_t) p_vout : 0);
+    atomic_store(&p_sys->observed_click_time, click_time);
+
+    struct toggle toggle;
+    int64_t control_time = _now_us();
+    player_toggle(intf, speculative, &toggle);
+    int64_t applied_time = _now_us();
+
+    if (toggle.in_menu) {
+        atomic_store(&p_sys->pause_vout, 0);
+        atomic_store(&p_sys->observed_click_time, 0);
+        log_event(intf, p_sys, LOG_IN_MENU, 0, 0, 0, 0);
+        counter_add(p_sys, COUNTER_MENU_SUPPRESSIONS);
+        return;
+    }
+
+    log_event(intf, p_sys, LOG_PAUSE_PLAY, 0, 0, 0, 0);
+    counter_add(p_sys, COUNTER_TOGGLES);
+    if (!toggle.playing && p_sys->frame_pacing) {
+        atomic_store_explicit(&p_sys->resume_time, control_time, memory_order_relaxed);
+    }
+    latency_record(p_sys, LATENCY_CONTROL, control_time, applied_time);
+    latency_record(p_sys, LATENCY_CLICK_TO_APPLIED, click_time, applied_time);
+
+    const bool playing = toggle.playing;
+    if (!playing) {
+        atomic_store(&p_sys->pause_vout, 0);
+    }
+    if (speculative) {
+        p_sys->rollback.valid = true;
+        p_sys->rollback.playing = playing;
+        p_sys->rollback.time = toggle.time;
+        counter_add(p_sys, COUNTER_SPECULATIONS);
+        atomic_store(&p_sys->latency_updated, true);
+    }
+    if (flags & PAUSE_PLAY_ICON) {
+        display_icon(p_sys, playing ? OSD_PAUSE_ICON : OSD_PLAY_ICON,
+                     flags & PAUSE_PLAY_ICON_ALL_VOUTS ? NULL : p_vout);
+    }
+}
+
+// Runs on the interface thread once the player has paused. Seeks back by as
+// much as the picture on the clicked vout's screen is past the clicked one.
+static void frame_seek(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+
+    vlc_object_t *p_vout = (vlc_object_t *) atomic_exchange(&p_sys->pause_vout, 0);
+    if (!p_vout) {
+        return;
+    }
+    int64_t frame_date = 0;
+    int64_t picture_date = 0;
+    vlc_mutex_lock(&p_sys->vouts_lock);
+    // the filter might have closed in the meantime
+    struct filter_sys_t *p_filter = filters_find(p_sys, p_vout);
+    if (p_filter) {
+        frame_date = atomic_exchange(&p_filter->pause_frame_date, 0);
+        picture_date = atomic_load(&p_filter->last_picture_date);
+    }
+    vlc_mutex_unlock(&p_sys->vouts_lock);
+    if (!frame_date) {
+        return;
+    }
+    int64_t drift = picture_date - frame_date;
+    latency_record(p_sys, LATENCY_FRAME_DRIFT, frame_date, frame_date + drift);
+    msg_Dbg(intf, "paused %" PRId64 "us past the clicked picture", drift);
+    if (drift <= 0) {
+        return;
+    }
+
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    // the picture dates are in the system clock, which runs at a different
+    // pace than the media one unless the rate is 1
+    input_thread_t *p_input = input_hold(intf);
+    if (!p_input) {
+        return;
+    }
+    drift = (int64_t) (drift * var_GetFloat(p_input, "rate"));
+    vlc_object_release(p_input);
+#endif
+    int64_t time = player_get_time(intf);
+    if (time < 0) {
+        return;
+    }
+    player_seek(intf, time > drift ? time - drift : 0);
+}
+
+// Runs on the interface thread. Puts the player back the way it was before
+// the last speculative pause/play
+static void rollback(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+
+    // it didn't get to pause/play, e.g. because of being in a menu
+    if (!p_sys->rollback.valid) {
+        return;
+    }
+    p_sys->rollback.valid = false;
+
+    log_event(intf, p_sys, LOG_ROLLBACK, 0, 0, 0, 0);
+    counter_add(p_sys, COUNTER_ROLLBACKS);
+    atomic_store(&p_sys->latency_updated, true);
+    atomic_store(&p_sys->pause_vout, 0);
+
+    player_set_playing(intf, p_sys->rollback.playing);
+    // a video that was playing has been paused right where it was, while a
+    // paused one has played for up to the double click interval
+    if (!p_sys->rollback.playing && p_sys->rollback.time >= 0) {
+        player_seek(intf, p_sys->rollback.time);
+    }
+}
+
+// Runs on the interface thread, for the gesture bindings
+static void toggle_fullscreen(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+    vlc_mutex_lock(&p_sys->vouts_lock);
+    for (size_t i = 0; i < p_sys->vouts_count; i ++) {
+        var_ToggleBool(p_sys->vouts[i], "fullscreen");
+    }
+    vlc_mutex_unlock(&p_sys->vouts_lock);
+}
+
+// Runs on the interface thread, for the gesture bindings. The same request
+// the vout makes on a right click
+static void popup_menu(intf_thread_t *intf)
+{
+    var_SetBool(_libvlc(VLC_OBJECT(intf)), "intf-popupmenu", true);
+}
+
+// Runs on the interface thread, for the gesture bindings
+static void set_fast(intf_thread_t *intf, bool fast)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+    if (fast) {
+        p_sys->normal_rate = player_get_rate(intf);
+        player_set_rate(intf, 2 * p_sys->normal_rate);
+    } else {
+        player_set_rate(intf, p_sys->normal_rate);
+    }
+}
+
+// Queues up pause/play for the interface thread, so that the caller, which is
+// the video output or the timer thread, doesn't wait on the player. p_vout is
+// the vout clicked on, or NULL if unknown
+static void request_pause_play(vlc_object_t *p_obj, intf_sys_t *p_intf_sys, const struct config *cfg,
+                               vlc_object_t *p_vout, int64_t click_time, int64_t frame_date,
+                               bool speculative)
+{
+    if (!ring_push(&p_intf_sys->commands, COMMAND_PAUSE_PLAY, click_time, (int64_t) (intptr_t) p_vout,
+                   frame_date, pause_play_flags(cfg, speculative))) {
+        counter_add(p_intf_sys, COUNTER_COMMANDS_DROPPED);
+        msg_Warn(p_obj, "the command queue is full, dropping pause/play");
+        return;
+    }
+    vlc_sem_post(&p_intf_sys->wakeup);
+}
+
+static void request_rollback(vlc_object_t *p_obj, intf_sys_t *p_intf_sys)
+{
+    if (!ring_push(&p_intf_sys->commands, COMMAND_ROLLBACK, 0, 0, 0, 0)) {
+        counter_add(p_intf_sys, COUNTER_COMMANDS_DROPPED);
+        msg_Warn(p_obj, "the command queue is full, dropping the rollback");
+        return;
+    }
+    vlc_sem_post(&p_intf_sys->wakeup);
+}
+
+static void request_command(vlc_object_t *p_obj, intf_sys_t *p_intf_sys, enum command command,
+                            int64_t arg, const char *psz_what)
+{
+    if (!ring_push(&p_intf_sys->commands, command, arg, 0, 0, 0)) {
+        counter_add(p_intf_sys, COUNTER_COMMANDS_DROPPED);
+        msg_Warn(p_obj, "the command queue is full, dropping %s", psz_what);
+        return;
+    }
+    vlc_sem_post(&p_intf_sys->wakeup);
+}
+
+// Queues up the scroll wheel notches gathered since the last picture, as one
+// seek and one volume change, so that a fast spin of the wheel doesn't flood
+// the demuxer with back-to-back seeks
+static void scroll_flush(struct filter_sys_t *p_sys)
+{
+    const int jumps = atomic_exchange_explicit(&p_sys->scroll_jumps, 0, memory_order_relaxed);
+    const int volume = atomic_exchange_explicit(&p_sys->scroll_volume, 0, memory_order_relaxed);
+    if (jumps) {
+        counter_add(p_sys->intf, COUNTER_WHEEL_BATCHES);
+        request_command(p_sys->obj, p_sys->intf, COMMAND_JUMP, jumps, "the seek");
+    }
+    if (volume) {
+        counter_add(p_sys->intf, COUNTER_WHEEL_BATCHES);
+        request_command(p_sys->obj, p_sys->intf, COMMAND_CHANGE_VOLUME, volume, "the volume change");
+    }
+}
+
+static void scroll_add(struct filter_sys_t *p_sys, unsigned actions)
+{
+    const int jumps = !!(actions & CLICK_ACTION_SEEK_FORWARD) - !!(actions & CLICK_ACTION_SEEK_BACKWARD);
+    const int volume = !!(actions & CLICK_ACTION_VOLUME_UP) - !!(actions & CLICK_ACTION_VOLUME_DOWN);
+    counter_add(p_sys->intf, COUNTER_WHEEL_NOTCHES);
+    atomic_fetch_add_explicit(&p_sys->scroll_jumps, jumps, memory_order_relaxed);
+    atomic_fetch_add_explicit(&p_sys->scroll_volume, volume, memory_order_relaxed);
+    // there are no pictures to batch up by in the mouse-only mode
+    if (p_sys->mouse_only) {
+        scroll_flush(p_sys);
+    } else if (!atomic_exchange(&p_sys->scroll_timer_armed, true)) {
+        timer_wheel_schedule(p_sys->wheel, &p_sys->scroll_timer, _now_us() + SCROLL_FLUSH_DELAY);
+    }
+}
+
+static void scroll_timer_callback(void *data)
+{
+    struct filter_sys_t *p_sys = (struct filter_sys_t *) data;
+    atomic_store(&p_sys->scroll_timer_armed, false);
+    scroll_flush(p_sys);
+}
+
+// Queues up the actions of the gesture bindings, which are carried out on the
+// player and the vouts instead of through the mouse state
+static void request_gesture_actions(struct filter_sys_t *p_sys, const struct config *cfg, unsigned actions,
+                                    vlc_object_t *p_vout, int64_t click_time, int64_t frame_date)
+{
+    if (actions & CLICK_ACTION_PAUSE_PLAY) {
+        request_pause_play(p_sys->obj, p_sys->intf, cfg, p_vout, click_time, frame_date, false);
+    }
+    if (actions & CLICK_ACTION_TOGGLE_FULLSCREEN) {
+        counter_add(p_sys->intf, COUNTER_FULLSCREEN);
+        request_command(p_sys->obj, p_sys->intf, COMMAND_TOGGLE_FULLSCREEN, 0, "the fullscreen toggle");
+    }
+    if (actions & CLICK_ACTION_POPUP_MENU) {
+        request_command(p_sys->obj, p_sys->intf, COMMAND_POPUP_MENU, 0, "the context menu");
+    }
+    if (actions & (CLICK_ACTION_FAST_FORWARD | CLICK_ACTION_NORMAL_RATE)) {
+        request_command(p_sys->obj, p_sys->intf, COMMAND_SET_FAST, actions & CLICK_ACTION_FAST_FORWARD,
+                        "the rate change");
+    }
+    if (actions & (CLICK_ACTION_SEEK_FORWARD | CLICK_ACTION_SEEK_BACKWARD |
+                   CLICK_ACTION_VOLUME_UP | CLICK_ACTION_VOLUME_DOWN)) {
+        scroll_add(p_sys, actions);
+    }
+}
+
+static void coalesce_timer_callback(void *data)
+{
+    intf_thread_t *intf = (intf_thread_t *) data;
+    request_command(VLC_OBJECT(intf), intf->p_sys, COMMAND_COALESCE_END, 0, "the end of the coalescing");
+}
+
+static void coalesce_open(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+    p_sys->coalesce.end = _now_us() + p_sys->coalesce.window;
+    timer_wheel_schedule(p_sys->wheel, &p_sys->coalesce.timer, p_sys->coalesce.end);
+}
+
+// Runs on the interface thread. Carries out the pause/play right away if no
+// coalescing window is open and opens one, otherwise holds it back until the
+// window ends.
+static void coalesce_pause_play(intf_thread_t *intf, const int64_t args[4])
+{
+    intf_sys_t *p_sys = intf->p_sys;
+
+    if (p_sys->coalesce.window == 0) {
+        pause_play(intf, args[0], (vlc_object_t *) (intptr_t) args[1], args[2], args[3]);
+        return;
+    }
+    if (p_sys->coalesce.end) {
+        p_sys->coalesce.pending ++;
+        memcpy(p_sys->coalesce.args, args, sizeof(p_sys->coalesce.args));
+        return;
+    }
+    pause_play(intf, args[0], (vlc_object_t *) (intptr_t) args[1], args[2], args[3]);
+    coalesce_open(intf);
+}
+
+// Runs on the interface thread. A rollback undoes the last pause/play, which
+// might still be held back.
+static void coalesce_rollback(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+
+    if (p_sys->coalesce.pending > 0) {
+        p_sys->coalesce.pending --;
+        counter_add(p_sys, COUNTER_TOGGLES_ABSORBED);
+        return;
+    }
+    rollback(intf);
+}
+
+// Runs on the interface thread. Folds the pause/plays held back during the
+// window into the net state change, which opens a new window if there is one.
+static void coalesce_end(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+
+    const unsigned pending = p_sys->coalesce.pending;
+    p_sys->coalesce.end = 0;
+    p_sys->coalesce.pending = 0;
+    if (pending == 0) {
+        return;
+    }
+    // every two of them cancel each other out, leaving a single toggle or none
+    const bool toggle = pending % 2;
+    counter_add_n(p_sys, COUNTER_TOGGLES_ABSORBED, pending - toggle);
+    atomic_store(&p_sys->latency_updated, true);
+    if (toggle) {
+        const int64_t *args = p_sys->coalesce.args;
+        pause_play(intf, args[0], (vlc_object_t *) (intptr_t) args[1], args[2], args[3]);
+        coalesce_open(intf);
+    }
+}
+
+static void commands_run(intf_thread_t *intf)
+{
+    int tag;
+    int64_t args[4];
+    while (ring_pop(&intf->p_sys->commands, &tag, args)) {
+        switch (tag) {
+            case COMMAND_PAUSE_PLAY:
+                coalesce_pause_play(intf, args);
+                break;
+            case COMMAND_ROLLBACK:
+                coalesce_rollback(intf);
+                break;
+            case COMMAND_FRAME_SEEK:
+                frame_seek(intf);
+                break;
+            case COMMAND_TOGGLE_FULLSCREEN:
+                toggle_fullscreen(intf);
+                break;
+            case COMMAND_POPUP_MENU:
+                popup_menu(intf);
+                break;
+            case COMMAND_SET_FAST:
+                set_fast(intf, args[0]);
+                break;
+            case COMMAND_JUMP:
+                player_jump(intf, args[0]);
+                break;
+            case COMMAND_CHANGE_VOLUME:
+                player_change_volume(intf, args[0]);
+                break;
+            case COMMAND_COALESCE_END:
+                coalesce_end(intf);
+                break;
+        }
+    }
+}
+
+static int64_t clock_now(void *opaque)
+{
+    UNUSED(opaque);
+    return _now_us();
+}
+
+static const struct click_clock now_clock = {clock_now, NULL};
+
+// Gets the current settings snapshot for a mouse or a timer callback, which
+// keeps it from being freed until config_release()
+static const struct config *config_acquire(struct filter_sys_t *p_sys)
+{
+    atomic_fetch_add(&p_sys->config_readers, 1);
+    return (const struct config *) atomic_load(&p_sys->config);
+}
+
+static void config_release(struct filter_sys_t *p_sys)
+{
+    atomic_fetch_sub(&p_sys->config_readers, 1);
+}
+
+// Frees the snapshots the current one has replaced. Must be called only once
+// nothing can read them anymore, that is with no callback reading a snapshot
+// or with the callbacks gone and the settings variables detached.
+static void config_prune(struct filter_sys_t *p_sys)
+{
+    struct config *cfg = (struct config *) atomic_load(&p_sys->config);
+    const struct config *p_prev = cfg->p_prev;
+    cfg->p_prev = NULL;
+    while (p_prev) {
+        const struct config *p_next = p_prev->p_prev;
+        free((void *) p_prev);
+        p_prev = p_next;
+    }
+}
+
+static void timer_start(struct filter_sys_t *p_sys, int64_t deadline)
+{
+    counter_add(p_sys->intf, COUNTER_TIMERS_SCHEDULED);
+    timer_wheel_schedule(p_sys->wheel, &p_sys->timer, deadline);
+}
+
+static void gesture_timer_callback(struct filter_sys_t *p_sys, const struct config *cfg)
+{
+    vlc_mutex_lock(&p_sys->lock);
+    const int64_t click_time = p_sys->gestures.press_time;
+    const unsigned actions = gesture_machine_timeout(&p_sys->gestures, &cfg->gestures,
+                                                     cfg->click.double_click_delay);
+    const int64_t deadline = p_sys->gestures.deadline;
+    const int64_t frame_date = p_sys->click_frame_date;
+    vlc_object_t *p_vout = p_sys->click_vout;
+    vlc_mutex_unlock(&p_sys->lock);
+
+    if (actions & CLICK_ACTION_TIMER_START) {
+        timer_start(p_sys, deadline);
+    }
+    if (actions & ~(CLICK_ACTION_TIMER_START | CLICK_ACTION_TIMER_CANCEL)) {
+        log_event(p_sys->obj, p_sys->intf, LOG_TIMER_EXPIRED, 0, 0, 0, 0);
+        counter_add(p_sys->intf, COUNTER_TIMERS_FIRED);
+        request_gesture_actions(p_sys, cfg, actions, p_vout, click_time, frame_date);
+    }
+}
+
+static void click_timer_callback(struct filter_sys_t *p_sys, const struct config *cfg)
+{
+
+    vlc_mutex_lock(&p_sys->lock);
+    const bool pending = p_sys->machine.state == CLICK_STATE_PENDING;
+    const unsigned actions = click_machine_timeout(&p_sys->machine, &cfg->click);
+    const int64_t click_time = p_sys->machine.click_time;
+    const int64_t deadline = p_sys->machine.deadline;
+    const int64_t frame_date = p_sys->click_frame_date;
+    vlc_object_t *p_vout = p_sys->click_vout;
+    vlc_mutex_unlock(&p_sys->lock);
+
+    if (!pending) {
+        return;
+    }
+    if (actions & CLICK_ACTION_TIMER_START) {
+        timer_start(p_sys, deadline);
+        return;
+    }
+
+    log_event(p_sys->obj, p_sys->intf, LOG_TIMER_EXPIRED, 0, 0, 0, 0);
+    counter_add(p_sys->intf, COUNTER_TIMERS_FIRED);
+    latency_record(p_sys->intf, LATENCY_CLICK_TO_TIMER, click_time, _now_us());
+    if (actions & CLICK_ACTION_PAUSE_PLAY) {
+        request_pause_play(p_sys->obj, p_sys->intf, cfg, p_vout, click_time, frame_date, false);
+    }
+}
+
+static void timer_callback(void* data)
+{
+    struct filter_sys_t *p_sys = (struct filter_sys_t *) data;
+    const struct config *cfg = config_acquire(p_sys);
+
+    if (!gesture_table_is_empty(&cfg->gestures)) {
+        gesture_timer_callback(p_sys, cfg);
+    } else {
+        click_timer_callback(p_sys, cfg);
+    }
+
+    config_release(p_sys);
+}
+
+static int cfg_get_mouse_button(vlc_object_t *p_obj, const char *cfg, int default_value) {
+    int mouse_button = mouse_button_values[default_value];
+    int mouse_button_index = var_GetInteger(p_obj, cfg);
+    if (mouse_button_index >= 0 && (size_t)mouse_button_index <= sizeof(mouse_button_values)-1) {
+        mouse_button = mouse_button_values[mouse_button_index];
+    }
+    return mouse_button;
+}
+
+// builds a new settings snapshot and makes it the current one
+static int config_publish(vlc_object_t *p_obj, struct filter_sys_t *p_sys)
+{
+    struct config *cfg = malloc(sizeof(*cfg));
+    if (!cfg) {
+        return VLC_ENOMEM;
+    }
+
+    cfg->version = atomic_fetch_add(&p_sys->config_version, 1) + 1;
+    cfg->click.mouse_button = cfg_get_mouse_button(p_obj, MOUSE_BUTTON_CFG, MOUSE_BUTTON_DEFAULT);
+    cfg->click.fs_mouse_button = cfg_get_mouse_button(p_obj, FS_TOGGLE_MOUSE_BUTTON_CFG,
+                                                      FS_TOGGLE_MOUSE_BUTTON_DEFAULT);
+    cfg->click.context_menu_mouse_button = cfg_get_mouse_button(p_obj, CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_CFG,
+                                                                CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_DEFAULT);
+    cfg->click.double_click_delay = var_GetInteger(p_obj, DOUBLE_CLICK_DELAY_CFG);
+    cfg->click.enable_double_click_delay = var_GetBool(p_obj, ENABLE_DOUBLE_CLICK_DELAY_CFG);
+    cfg->click.ignore_double_click = var_GetBool(p_obj, IGNORE_DOUBLE_CLICK_CFG);
+    cfg->click.speculative = var_GetBool(p_obj, SPECULATIVE_CFG);
+    cfg->click.adaptive_double_click_delay = var_GetBool(p_obj, ADAPTIVE_DOUBLE_CLICK_DELAY_CFG);
+    cfg->click.disable_fs_toggle = var_GetBool(p_obj, DISABLE_FS_TOGGLE_CFG);
+    cfg->click.disable_context_menu_toggle = var_GetBool(p_obj, DISABLE_CONTEXT_MENU_TOGGLE_CFG);
+    // the mouse state VLC sees can't be changed in the mouse-only mode, so
+    // the fullscreen and context menu options are left out
+    if (p_sys->mouse_only) {
+        cfg->click.fs_mouse_button = CLICK_BUTTON_NONE;
+        cfg->click.context_menu_mouse_button = CLICK_BUTTON_NONE;
+        cfg->click.disable_fs_toggle = false;
+        cfg->click.disable_context_menu_toggle = false;
+    }
+    // the vout mouse variable has the raw button state, without VLC's double
+    // click detection
+    cfg->click.double_click_is_click = LIBVLC_VERSION_MAJOR <= 3 && !p_sys->mouse_only;
+    cfg->click.fs_toggle_presses_left = LIBVLC_VERSION_MAJOR >= 4;
+    char *psz_gestures = var_GetString(p_obj, GESTURES_CFG);
+    size_t error = 0;
+    if (!gesture_table_compile(&cfg->gestures, psz_gestures ? psz_gestures : "", &error)) {
+        msg_Err(p_obj, "invalid gesture binding \"%s\", ignoring the gesture bindings",
+                psz_gestures + error);
+    }
+    free(psz_gestures);
+    if (gesture_table_is_empty(&cfg->gestures)) {
+        click_interest_init(&cfg->interest, &cfg->click);
+    } else {
+        gesture_interest_init(&cfg->interest, &cfg->gestures);
+    }
+    cfg->display_icon = var_GetBool(p_obj, DISPLAY_ICON_CFG);
+    cfg->display_icon_on_all_vouts = var_GetBool(p_obj, DISPLAY_ICON_ON_ALL_VOUTS_CFG);
+    // there are no pictures to date the clicks with in the mouse-only mode
+    cfg->frame_accurate = var_GetBool(p_obj, FRAME_ACCURATE_CFG) && !p_sys->mouse_only;
+
+    if (p_sys->intf->trace) {
+        vlc_mutex_lock(&p_sys->lock);
+        const int64_t learned_delay = p_sys->machine.learned_delay;
+        vlc_mutex_unlock(&p_sys->lock);
+        struct trace_record recs[2];
+        size_t count = trace_config_to_records(&cfg->click, learned_delay, &cfg->gestures,
+                                               _now_us(), recs);
+        trace_write_n(p_sys->intf->trace, recs, count);
+    }
+
+    // the previous snapshots might still be in use by a callback, so they
+    // are chained to the new one, and freed as soon as no callback reads any.
+    // A callback that comes after the exchange can only get the new one
+    vlc_mutex_lock(&p_sys->config_lock);
+    cfg->p_prev = (const struct config *) atomic_exchange(&p_sys->config, (uintptr_t) cfg);
+    if (atomic_load(&p_sys->config_readers) == 0) {
+        config_prune(p_sys);
+    }
+    vlc_mutex_unlock(&p_sys->config_lock);
+
+    msg_Dbg(p_obj, "settings snapshot v%u published", cfg->version);
+
+    return VLC_SUCCESS;
+}
+
+static int config_callback(vlc_object_t *p_this, char const *psz_var,
+                           vlc_value_t oldval, vlc_value_t newval, void *p_data)
+{
+    UNUSED(psz_var);
+    UNUSED(oldval);
+    UNUSED(newval);
+
+    // the variable has already been set by the time we are called
+    return config_publish(p_this, (struct filter_sys_t *) p_data);
+}
+
+static void config_vars_create(vlc_object_t *p_obj)
+{
+    for (size_t i = 0; i < sizeof(config_vars)/sizeof(config_vars[0]); i ++) {
+        var_Create(p_obj, config_vars[i].name, config_vars[i].type | VLC_VAR_DOINHERIT);
+    }
+}
+
+// Passes a setting changed on the libvlc object, where the command line and
+// the libvlc_new() options are, down to the object's variable, whose callback
+// publishes the snapshot
+static int config_libvlc_callback(vlc_object_t *p_this, char const *psz_var,
+                                  vlc_value_t oldval, vlc_value_t newval, void *p_data)
+{
+    UNUSED(p_this);
+    UNUSED(oldval);
+
+    return var_Set(((struct filter_sys_t *) p_data)->obj, psz_var, newval);
+}
+
+// updates if user changes the setting, on the object or on the libvlc object.
+// Preferences only changes the config, which the variables inherit from when
+// created, so its changes apply from the next vout on
+static void config_follow(vlc_object_t *p_obj, struct filter_sys_t *p_sys)
+{
+    libvlc_int_t *p_libvlc = _libvlc(p_obj);
+    for (size_t i = 0; i < sizeof(config_vars)/sizeof(config_vars[0]); i ++) {
+        var_AddCallback(p_obj, config_vars[i].name, config_callback, p_sys);
+        var_Create(p_libvlc, config_vars[i].name, config_vars[i].type | VLC_VAR_DOINHERIT);
+        var_AddCallback(p_libvlc, config_vars[i].name, config_libvlc_callback, p_sys);
+    }
+}
+
+static int config_init(vlc_object_t *p_obj, struct filter_sys_t *p_sys)
+{
+    atomic_init(&p_sys->config, (uintptr_t) NULL);
+    atomic_init(&p_sys->config_version, 0);
+    atomic_init(&p_sys->config_readers, 0);
+    vlc_mutex_init(&p_sys->config_lock);
+
+    config_vars_create(p_obj);
+
+    if (config_publish(p_obj, p_sys) != VLC_SUCCESS) {
+        for (size_t i = 0; i < sizeof(config_vars)/sizeof(config_vars[0]); i ++) {
+            var_Destroy(p_obj, config_vars[i].name);
+        }
+        _vlc_mutex_destroy(&p_sys->config_lock);
+        return VLC_ENOMEM;
+    }
+
+    config_follow(p_obj, p_sys);
+
+    return VLC_SUCCESS;
+}
+
+// Moves the settings variables over to another object. The variables inherit
+// the current config, which Preferences changes without going through them,
+// so the snapshot is published anew from them. The previous one is kept if
+// that fails.
+static void config_attach(vlc_object_t *p_obj, struct filter_sys_t *p_sys)
+{
+    config_vars_create(p_obj);
+    config_publish(p_obj, p_sys);
+    config_follow(p_obj, p_sys);
+}
+
+static void config_detach(vlc_object_t *p_obj, struct filter_sys_t *p_sys)
+{
+    libvlc_int_t *p_libvlc = _libvlc(p_obj);
+    for (size_t i = 0; i < sizeof(config_vars)/sizeof(config_vars[0]); i ++) {
+        var_DelCallback(p_libvlc, config_vars[i].name, config_libvlc_callback, p_sys);
+        var_Destroy(p_libvlc, config_vars[i].name);
+        var_DelCallback(p_obj, config_vars[i].name, config_callback, p_sys);
+        var_Destroy(p_obj, config_vars[i].name);
+    }
+}
+
+static void config_free(struct filter_sys_t *p_sys)
+{
+    const struct config *cfg = (const struct config *) atomic_load(&p_sys->config);
+    while (cfg) {
+        const struct config *p_prev = cfg->p_prev;
+        free((void *) cfg);
+        cfg = p_prev;
+    }
+    _vlc_mutex_destroy(&p_sys->config_lock);
+}
+
+static void trace_mouse(intf_sys_t *p_intf_sys, int64_t time, const vlc_mouse_t *p_mouse_old,
+                        const vlc_mouse_t *p_mouse_new)
+{
+    if (!p_intf_sys->trace) {
+        return;
+    }
+
+    struct trace_record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.type = TRACE_RECORD_MOUSE;
+    rec.time = time;
+    rec.u.mouse.old_x = p_mouse_old->i_x;
+    rec.u.mouse.old_y = p_mouse_old->i_y;
+    rec.u.mouse.old_pressed = p_mouse_old->i_pressed;
+    rec.u.mouse.old_double_click = p_mouse_old->b_double_click;
+    rec.u.mouse.new_x = p_mouse_new->i_x;
+    rec.u.mouse.new_y = p_mouse_new->i_y;
+    rec.u.mouse.new_pressed = p_mouse_new->i_pressed;
+    rec.u.mouse.new_double_click = p_mouse_new->b_double_click;
+    trace_write(p_intf_sys->trace, &rec);
+}
+
+// p_vout is the vout the mouse event comes from, or NULL if unknown
+static int mouse_process(struct filter_sys_t *p_sys, vlc_object_t *p_vout, vlc_mouse_t *p_mouse_out,
+                         const vlc_mouse_t *p_mouse_old, const vlc_mouse_t *p_mouse_new)
+{
+    const int64_t now = _now_us();
+
+    trace_mouse(p_sys->intf, now, p_mouse_old, p_mouse_new);
+    counter_add(p_sys->intf, COUNTER_EVENTS);
+
+    *p_mouse_out = *p_mouse_new;
+
+    const struct click_mouse old = {p_mouse_old->i_pressed, p_mouse_old->b_double_click};
+    const struct click_mouse new = {p_mouse_new->i_pressed, p_mouse_new->b_double_click};
+
+    // get the current settings snapshot. updates if user changes the setting
+    const struct config *cfg = config_acquire(p_sys);
+
+    // we don't want to process anything if no button we act on has changed,
+    // e.g. when moving the mouse with a button held down
+    if (click_logic_is_uninteresting(&cfg->interest, &old, &new)) {
+        counter_add(p_sys->intf, COUNTER_EARLY_OUTS);
+        config_release(p_sys);
+        return VLC_SUCCESS;
+    }
+
+    enum log_tag tag;
+    if (p_mouse_new->b_double_click) {
+        tag = LOG_DOUBLE_CLICK;
+    } else if (p_mouse_old->i_pressed < p_mouse_new->i_pressed) {
+        tag = LOG_PRESSED;
+    } else if (p_mouse_old->i_pressed > p_mouse_new->i_pressed) {
+        tag = LOG_RELEASED;
+    } else if (p_mouse_old->i_pressed != 0) {
+        tag = LOG_DRAGGED;
+    } else {
+        tag = LOG_MOVED;
+    }
+    log_event(p_sys->obj, p_sys->intf, tag, p_mouse_old->i_pressed, p_mouse_old->b_double_click,
+              p_mouse_new->i_pressed, p_mouse_new->b_double_click);
+    UNUSED(tag);
+
+    log_event(p_sys->obj, p_sys->intf, LOG_MOUSE_BUTTON, cfg->click.mouse_button, 0, 0, 0);
+
+    // the picture on the screen at the moment of the click
+    const int64_t frame_date = cfg->frame_accurate ? atomic_load(&p_sys->last_picture_date) : 0;
+
+    const bool gestures = !gesture_table_is_empty(&cfg->gestures);
+    struct click_mouse out;
+    unsigned actions;
+    int64_t deadline;
+    vlc_mutex_lock(&p_sys->lock);
+    if (gestures) {
+        actions = gesture_machine_mouse(&p_sys->gestures, &cfg->gestures, cfg->click.double_click_delay,
+                                        cfg->click.double_click_is_click, &old, &new, &out);
+        deadline = p_sys->gestures.deadline;
+    } else {
+        actions = click_machine_mouse(&p_sys->machine, &cfg->click, &old, &new, &out);
+        deadline = p_sys->machine.deadline;
+    }
+    if (actions & CLICK_ACTION_TIMER_START) {
+        p_sys->click_frame_date = frame_date;
+        p_sys->click_vout = p_vout;
+    }
+    vlc_mutex_unlock(&p_sys->lock);
+    p_mouse_out->i_pressed = out.pressed;
+    p_mouse_out->b_double_click = out.double_click;
+
+    if (gestures) {
+        request_gesture_actions(p_sys, cfg, actions, p_vout, now, frame_date);
+    } else if (actions & CLICK_ACTION_PAUSE_PLAY) {
+        // it comes with the timer only in the speculative mode
+        const bool speculative = actions & CLICK_ACTION_TIMER_START &&
+                                 cfg->click.ignore_double_click && cfg->click.speculative;
+        request_pause_play(p_sys->obj, p_sys->intf, cfg, p_vout, now, frame_date, speculative);
+    }
+    if (actions & CLICK_ACTION_ROLLBACK) {
+        request_rollback(p_sys->obj, p_sys->intf);
+    }
+    if (actions & CLICK_ACTION_TIMER_CANCEL) {
+        // it's a double click -- cancel the scheduled timer
+        timer_wheel_cancel(p_sys->wheel, &p_sys->timer);
+        log_event(p_sys->obj, p_sys->intf, LOG_TIMER_CANCELLED, 0, 0, 0, 0);
+        counter_add(p_sys->intf, COUNTER_TIMERS_CANCELLED);
+    }
+    if (actions & CLICK_ACTION_SET_FULLSCREEN) {
+        counter_add(p_sys->intf, COUNTER_FULLSCREEN);
+    }
+    if (actions & CLICK_ACTION_TIMER_START) {
+        // it might be a single click -- schedule a timer
+        timer_start(p_sys, deadline);
+        log_event(p_sys->obj, p_sys->intf, LOG_TIMER_STARTED, (deadline - now) / 1000, 0, 0, 0);
+    }
+
+    log_event(p_sys->obj, p_sys->intf, LOG_OUT, p_mouse_out->i_pressed, p_mouse_out->b_double_click, 0, 0);
+
+    config_release(p_sys);
+
+    return VLC_SUCCESS;
+}
+
+static int mouse(filter_t *p_filter, vlc_mouse_t *p_mouse_out, const vlc_mouse_t *p_mouse_old, const vlc_mouse_t *p_mouse_new)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+    return mouse_process(p_sys, p_sys->vout, p_mouse_out, p_mouse_old, p_mouse_new);
+}
+
+// The mouse-only mode gets the mouse button state straight from the vout's
+// variable, so nothing sits in the picture path. The mouse state VLC sees
+// can't be changed from here, only pause/play is handled.
+static int vout_mouse_callback(vlc_object_t *p_this, char const *psz_var,
+                               vlc_value_t oldval, vlc_value_t newval, void *p_data)
+{
+    UNUSED(psz_var);
+
+    vlc_mouse_t old, new, out;
+    vlc_mouse_Init(&old);
+    vlc_mouse_Init(&new);
+    old.i_pressed = oldval.i_int;
+    new.i_pressed = newval.i_int;
+
+    return mouse_process((struct filter_sys_t *) p_data, p_this, &out, &old, &new);
+}
+
+// Measures the pictures that come after a resume: the time until the first
+// one, then how far the time between them is off the frame period
+static void frame_pacing_record(struct filter_sys_t *p_sys, int64_t resume)
+{
+    const int64_t now = _now_us();
+
+    if (resume != p_sys->pacing_resume) {
+        p_sys->pacing_resume = resume;
+        // a filter opened long after the resume, e.g. for the next item, has
+        // not seen its first picture
+        if (now - resume > FRAME_PACING_WINDOW) {
+            p_sys->pacing_last = 0;
+            return;
+        }
+        p_sys->pacing_last = now;
+        latency_record(p_sys->intf, LATENCY_RESUME_TO_FRAME, resume, now);
+        return;
+    }
+    if (!p_sys->pacing_last) {
+        return;
+    }
+    if (now - resume > FRAME_PACING_WINDOW) {
+        p_sys->pacing_last = 0;
+        return;
+    }
+    const int64_t interval = now - p_sys->pacing_last;
+    const int64_t jitter = p_sys->frame_period ? interval - p_sys->frame_period : interval;
+    histogram_record(&p_sys->intf->latency[LATENCY_RESUME_JITTER], jitter < 0 ? -jitter : jitter);
+    atomic_store(&p_sys->intf->latency_updated, true);
+    p_sys->pacing_last = now;
+}
+
+static picture_t *filter(filter_t *p_filter, picture_t *p_pic_in)
+{
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+
+    const int64_t resume = atomic_load_explicit(&p_sys->intf->resume_time, memory_order_relaxed);
+    if (resume) {
+        frame_pacing_record(p_sys, resume);
+    }
+
+    atomic_store_explicit(&p_sys->last_picture_date, _picture_date_us(p_pic_in),
+                          memory_order_relaxed);
+
+    if (atomic_load_explicit(&p_sys->scroll_jumps, memory_order_relaxed) ||
+            atomic_load_explicit(&p_sys->scroll_volume, memory_order_relaxed)) {
+        scroll_flush(p_sys);
+    }
+
+    // don't alter picture
+    return p_pic_in;
+}
+
+#if LIBVLC_VERSION_MAJOR >= 4
 // VLC 4.0 changed mouse callback's signature, so we adapt it to the VLC2/VLC3
 // callback in order to use the same function for all versions
 static int _mouse(filter_t *p_filter, vlc_mouse_t *p_mouse_new_out, const vlc_mouse_t *p_mouse_old)
@@ -593,29 +2457,306 @@ static void print_version(vlc_object_t *p_obj)
     msg_Dbg(p_obj, VERSION_HOMEPAGE);
 }
 
+// Finds the context of the interface of the object's libvlc instance and takes
+// a reference to it. Returns NULL if the interface isn't running.
+static intf_sys_t *intf_sys_find(vlc_object_t *p_obj)
+{
+    vlc_mutex_lock(&intf_lock);
+    intf_sys_t *p_sys = var_GetAddress(_libvlc(p_obj), INTF_VAR);
+    if (p_sys) {
+        atomic_fetch_add(&p_sys->refs, 1);
+    }
+    vlc_mutex_unlock(&intf_lock);
+
+    return p_sys;
+}
+
+static void intf_sys_release(intf_sys_t *p_sys)
+{
+    if (atomic_fetch_sub(&p_sys->refs, 1) != 1) {
+        return;
+    }
+
+    if (p_sys->trace) {
+        fclose(p_sys->trace);
+    }
+    _vlc_mutex_destroy(&p_sys->vouts_lock);
+    _vlc_sem_destroy(&p_sys->wakeup);
+    free(p_sys);
+}
+
+// Sets up the click handling state. Takes over the caller's reference to
+// p_intf_sys on success.
+static int filter_sys_init(vlc_object_t *p_obj, struct filter_sys_t *p_sys, intf_sys_t *p_intf_sys,
+                           bool mouse_only)
+{
+    p_sys->obj = p_obj;
+    p_sys->mouse_only = mouse_only;
+    p_sys->intf = p_intf_sys;
+    p_sys->wheel = timer_wheel_acquire();
+    if (!p_sys->wheel) {
+        msg_Err(p_obj, "failed to create a timer");
+        return VLC_EGENERIC;
+    }
+    vlc_mutex_init(&p_sys->lock);
+    click_machine_init(&p_sys->machine, &now_clock);
+    gesture_machine_init(&p_sys->gestures, &now_clock);
+    // set before the settings snapshot, which records it in the trace
+    p_sys->machine.learned_delay = var_InheritInteger(p_obj, LEARNED_DOUBLE_CLICK_DELAY_CFG);
+    if (config_init(p_obj, p_sys) != VLC_SUCCESS) {
+        _vlc_mutex_destroy(&p_sys->lock);
+        timer_wheel_release(p_sys->wheel);
+        return VLC_ENOMEM;
+    }
+    atomic_init(&p_sys->scroll_jumps, 0);
+    atomic_init(&p_sys->scroll_volume, 0);
+    timer_wheel_entry_init(&p_sys->scroll_timer, scroll_timer_callback, p_sys);
+    atomic_init(&p_sys->scroll_timer_armed, false);
+    p_sys->click_frame_date = 0;
+    p_sys->click_vout = NULL;
+    p_sys->vout = NULL;
+    atomic_init(&p_sys->last_picture_date, 0);
+    atomic_init(&p_sys->pause_frame_date, 0);
+    p_sys->frame_period = 0;
+    p_sys->pacing_resume = 0;
+    p_sys->pacing_last = 0;
+    timer_wheel_entry_init(&p_sys->timer, timer_callback, p_sys);
+
+    return VLC_SUCCESS;
+}
+
+// keeps the learned double click interval for the next session. VLC writes
+// the changed config to the disk on exit
+static void learned_delay_save(vlc_object_t *p_obj, struct filter_sys_t *p_sys)
+{
+    const struct config *cfg = (const struct config *) atomic_load(&p_sys->config);
+    if (!cfg->click.adaptive_double_click_delay || !click_machine_has_learned(&p_sys->machine)) {
+        return;
+    }
+    int64_t delay = click_machine_delay(&p_sys->machine, &cfg->click);
+    msg_Dbg(p_obj, "learned double click interval: %" PRId64 "ms", delay);
+    _config_PutInt(p_obj, LEARNED_DOUBLE_CLICK_DELAY_CFG, delay);
+}
+
+// Lets go of the object, keeping the click state, such as the learned double
+// click interval, and the current settings snapshot. The object's mouse
+// callback must be gone by now
+static void filter_sys_detach(struct filter_sys_t *p_sys)
+{
+    // waits for the timer callbacks to return
+    timer_wheel_cancel(p_sys->wheel, &p_sys->timer);
+    timer_wheel_cancel(p_sys->wheel, &p_sys->scroll_timer);
+    atomic_store(&p_sys->scroll_timer_armed, false);
+    scroll_flush(p_sys);
+    // waits for the settings callbacks to return
+    config_detach(p_sys->obj, p_sys);
+    // so that a state reopened over and over doesn't pile them up
+    config_prune(p_sys);
+    p_sys->obj = NULL;
+}
+
+// Takes a detached state over for the object. With same_video, the filter is
+// reopened on the vout the state was parked from for the same input, which is
+// a reconfiguration, and a pending click goes on firing. Otherwise the click
+// was made on another video, so it's dropped, and the state starts over as a
+// new one would, the learned interval going through the config.
+static void filter_sys_attach(vlc_object_t *p_obj, struct filter_sys_t *p_sys, bool same_video)
+{
+    p_sys->obj = p_obj;
+    unsigned actions = 0;
+    if (!same_video) {
+        learned_delay_save(p_obj, p_sys);
+        vlc_mutex_lock(&p_sys->lock);
+        click_machine_init(&p_sys->machine, &now_clock);
+        p_sys->machine.learned_delay = var_InheritInteger(p_obj, LEARNED_DOUBLE_CLICK_DELAY_CFG);
+        actions = gesture_machine_cancel(&p_sys->gestures);
+        p_sys->click_frame_date = 0;
+        p_sys->click_vout = NULL;
+        vlc_mutex_unlock(&p_sys->lock);
+        p_sys->pacing_resume = 0;
+        p_sys->pacing_last = 0;
+    }
+    config_attach(p_obj, p_sys);
+    if (actions & CLICK_ACTION_NORMAL_RATE) {
+        request_command(p_obj, p_sys->intf, COMMAND_SET_FAST, false, "the normal rate");
+    }
+    if (same_video) {
+        // its timer was cancelled on detach
+        const struct config *cfg = (const struct config *) atomic_load(&p_sys->config);
+        vlc_mutex_lock(&p_sys->lock);
+        const int64_t deadline = gesture_table_is_empty(&cfg->gestures) ? p_sys->machine.deadline
+                                                                        : p_sys->gestures.deadline;
+        vlc_mutex_unlock(&p_sys->lock);
+        if (deadline) {
+            timer_start(p_sys, deadline);
+        }
+    }
+}
+
+// frees a detached state. p_obj is the object to save the learned interval
+// through
+static void filter_sys_free(vlc_object_t *p_obj, struct filter_sys_t *p_sys)
+{
+    learned_delay_save(p_obj, p_sys);
+    timer_wheel_release(p_sys->wheel);
+    _vlc_mutex_destroy(&p_sys->lock);
+    config_free(p_sys);
+    intf_sys_release(p_sys->intf);
+}
+
+static void filter_sys_destroy(struct filter_sys_t *p_sys)
+{
+    vlc_object_t *p_obj = p_sys->obj;
+    filter_sys_detach(p_sys);
+    filter_sys_free(p_obj, p_sys);
+}
+
+// VLC closes and reopens the filter on every vout reconfiguration, e.g. on a
+// resolution or playlist item change, so the state of a closed filter is
+// parked for the next one to take over. Returns false if the interface is
+// closing.
+static bool pool_put(struct filter_sys_t *p_sys, vlc_object_t *p_vout)
+{
+    intf_sys_t *p_intf_sys = p_sys->intf;
+    p_sys->parked_vout = p_vout;
+    p_sys->parked_input = atomic_load(&p_intf_sys->input_changes);
+    vlc_mutex_lock(&intf_lock);
+    const bool open = p_intf_sys->pool_open;
+    if (open) {
+        p_sys->p_next = p_intf_sys->pool;
+        p_intf_sys->pool = p_sys;
+    }
+    vlc_mutex_unlock(&intf_lock);
+    return open;
+}
+
+// Takes the state parked from the vout for the current input if there is one,
+// telling so through *p_same, or else any parked state. p_vout is NULL for any
+static struct filter_sys_t *pool_take(intf_sys_t *p_intf_sys, vlc_object_t *p_vout, bool *p_same)
+{
+    const unsigned input = atomic_load(&p_intf_sys->input_changes);
+    vlc_mutex_lock(&intf_lock);
+    struct filter_sys_t **pp_sys = &p_intf_sys->pool;
+    for (struct filter_sys_t **pp = pp_sys; p_vout && *pp; pp = &(*pp)->p_next) {
+        if ((*pp)->parked_vout == p_vout && (*pp)->parked_input == input) {
+            pp_sys = pp;
+            break;
+        }
+    }
+    struct filter_sys_t *p_sys = *pp_sys;
+    if (p_sys) {
+        *pp_sys = p_sys->p_next;
+    }
+    vlc_mutex_unlock(&intf_lock);
+    *p_same = p_sys && p_vout && p_sys->parked_vout == p_vout && p_sys->parked_input == input;
+    return p_sys;
+}
+
+static void pool_drain(intf_thread_t *intf)
+{
+    vlc_mutex_lock(&intf_lock);
+    intf->p_sys->pool_open = false;
+    vlc_mutex_unlock(&intf_lock);
+
+    struct filter_sys_t *p_sys;
+    bool same;
+    while ((p_sys = pool_take(intf->p_sys, NULL, &same))) {
+        filter_sys_free(VLC_OBJECT(intf), p_sys);
+        free(p_sys);
+    }
+}
+
+// hardware surfaces have no planes we could access
+static bool is_opaque_chroma(vlc_fourcc_t i_chroma)
+{
+    const vlc_chroma_description_t *p_desc = vlc_fourcc_GetChromaDescription(i_chroma);
+    return !p_desc || p_desc->plane_count == 0;
+}
+
+// whether the diagnostics are asked for, through the option or VLC's debug
+// verbosity, so that the work that only goes into them can be skipped on the
+// vout startup path
+static bool debug_enabled(vlc_object_t *p_obj)
+{
+    return var_InheritBool(p_obj, DEBUG_CFG) || var_InheritInteger(p_obj, "verbose") >= 2;
+}
+
 static int OpenFilter(vlc_object_t *p_this)
 {
     filter_t *p_filter = (filter_t *) p_this;
 
     print_version(p_this);
+    const bool debug = debug_enabled(p_this);
     msg_Dbg(p_filter, "filter sub-plugin opened");
-    if (!p_intf) {
+    intf_sys_t *p_intf_sys = intf_sys_find(p_this);
+    if (!p_intf_sys) {
         msg_Err(p_filter, "interface sub-plugin is not initialized. "
                 "Did you tick \"Pause/Play video on mouse click\" checkbox in "
                 "Preferences -> All -> Interface -> Control interfaces? "
                 "Don't forget to restart VLC afterwards");
         return VLC_EGENERIC;
     }
-    video_format_Print(p_this, "pause_click FORMAT IN:", &p_filter->fmt_in.video);
-    video_format_Print(p_this, "pause_click FORMAT OUT:", &p_filter->fmt_out.video);
-    msg_Dbg(p_filter, "b_allow_fmt_out_change=%d", p_filter->b_allow_fmt_out_change);
-    int interlaced = is_interlaced();
-    msg_Dbg(p_filter, "is_interlaced()=%d", interlaced);
+    if (p_intf_sys->mouse_only) {
+        if (vout_has_mouse_var(_vlc_object_parent(p_this))) {
+            msg_Dbg(p_filter, "the interface watches the mouse by itself, the filter is not needed");
+            intf_sys_release(p_intf_sys);
+            return VLC_EGENERIC;
+        }
+        msg_Dbg(p_filter, "the interface can't watch the mouse of this video output, "
+                "falling back to the filter");
+    }
+    if (debug) {
+        video_format_Print(p_this, "pause_click FORMAT IN:", &p_filter->fmt_in.video);
+        video_format_Print(p_this, "pause_click FORMAT OUT:", &p_filter->fmt_out.video);
+        msg_Dbg(p_filter, "b_allow_fmt_out_change=%d", p_filter->b_allow_fmt_out_change);
+        int interlaced = is_interlaced(p_this, p_intf_sys);
+        msg_Dbg(p_filter, "is_interlaced()=%d", interlaced);
+        msg_Dbg(p_filter, "%s chroma, passing pictures through",
+                is_opaque_chroma(p_filter->fmt_in.video.i_chroma) ? "opaque" : "software");
+    }
 
+    // the pictures are passed through untouched, opaque hardware surfaces
+    // included, so never make the chain convert them for us
     if (p_filter->fmt_out.video.i_chroma != p_filter->fmt_in.video.i_chroma) {
-        msg_Err(p_filter, "this filter doesn't do video conversion");
-        return VLC_EGENERIC;
+        if (!p_filter->b_allow_fmt_out_change) {
+            msg_Err(p_filter, "this filter doesn't do video conversion");
+            intf_sys_release(p_intf_sys);
+            return VLC_EGENERIC;
+        }
+        p_filter->fmt_out.video.i_chroma = p_filter->fmt_in.video.i_chroma;
+    }
+
+    // the filter is a child of the vout it filters for
+    vlc_object_t *p_vout = _vlc_object_parent(p_this);
+    bool same_video;
+    struct filter_sys_t *p_sys = pool_take(p_intf_sys, p_vout, &same_video);
+    if (p_sys) {
+        // the parked state holds a reference of its own
+        intf_sys_release(p_intf_sys);
+        filter_sys_attach(p_this, p_sys, same_video);
+        msg_Dbg(p_filter, "took over the state of a closed filter%s",
+                same_video ? " of the same vout" : "");
+    } else {
+        p_sys = malloc(sizeof(*p_sys));
+        if (!p_sys) {
+            intf_sys_release(p_intf_sys);
+            return VLC_ENOMEM;
+        }
+        int ret = filter_sys_init(p_this, p_sys, p_intf_sys, false);
+        if (ret != VLC_SUCCESS) {
+            intf_sys_release(p_intf_sys);
+            free(p_sys);
+            return ret;
+        }
     }
+    p_filter->p_sys = p_sys;
+    p_sys->vout = p_vout;
+    atomic_store(&p_sys->last_picture_date, 0);
+    atomic_store(&p_sys->pause_frame_date, 0);
+    filters_add(p_sys->intf, p_sys);
+    const video_format_t *p_fmt = &p_filter->fmt_in.video;
+    p_sys->frame_period = p_fmt->i_frame_rate ?
+                          INT64_C(1000000) * p_fmt->i_frame_rate_base / p_fmt->i_frame_rate : 0;
 
 #if LIBVLC_VERSION_MAJOR >= 4
     p_filter->ops = &filter_ops;
@@ -624,13 +2765,6 @@ static int OpenFilter(vlc_object_t *p_this)
     p_filter->pf_video_mouse = mouse;
 #endif
 
-    if (vlc_timer_create(&timer, &timer_callback, p_filter)) {
-        msg_Err(p_filter, "failed to create a timer");
-        return VLC_EGENERIC;
-    }
-    timer_initialized = true;
-    atomic_store(&timer_scheduled, false);
-
     return VLC_SUCCESS;
 }
 
@@ -638,26 +2772,215 @@ static void CloseFilter(vlc_object_t *p_this)
 {
     msg_Dbg(p_this, "filter sub-plugin closed");
 
-    if (timer_initialized) {
-        vlc_timer_destroy(timer);
-        timer_initialized = false;
-        atomic_store(&timer_scheduled, false);
+    filter_t *p_filter = (filter_t *) p_this;
+    struct filter_sys_t *p_sys = p_filter->p_sys;
+    filters_remove(p_sys->intf, p_sys);
+    vlc_object_t *p_vout = p_sys->vout;
+    p_sys->vout = NULL;
+    filter_sys_detach(p_sys);
+    if (!pool_put(p_sys, p_vout)) {
+        filter_sys_free(p_this, p_sys);
+        free(p_sys);
+    }
+}
+
+// In the mouse-only mode the interface handles the clicks of all the vouts by
+// itself
+static void mouse_only_init(intf_thread_t *intf)
+{
+    intf_sys_t *p_sys = intf->p_sys;
+
+    struct filter_sys_t *p_state = malloc(sizeof(*p_state));
+    if (!p_state) {
+        return;
+    }
+    atomic_fetch_add(&p_sys->refs, 1);
+    if (filter_sys_init(VLC_OBJECT(intf), p_state, p_sys, true) != VLC_SUCCESS) {
+        msg_Err(intf, "failed to set up the mouse-only mode, use the video filter instead");
+        atomic_fetch_sub(&p_sys->refs, 1);
+        free(p_state);
+        return;
+    }
+    p_sys->mouse_only = p_state;
+
+    if (var_InheritBool(intf, DISABLE_FS_TOGGLE_CFG) != DISABLE_FS_TOGGLE_DEFAULT ||
+            var_InheritInteger(intf, FS_TOGGLE_MOUSE_BUTTON_CFG) != FS_TOGGLE_MOUSE_BUTTON_DEFAULT ||
+            var_InheritBool(intf, DISABLE_CONTEXT_MENU_TOGGLE_CFG) != DISABLE_CONTEXT_MENU_TOGGLE_DEFAULT ||
+            var_InheritInteger(intf, CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_CFG) !=
+                CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_DEFAULT) {
+        msg_Warn(intf, "the fullscreen and context menu options are ignored in the mouse-only mode");
+    }
+}
+
+// must be called once the vouts are unhooked
+static void mouse_only_destroy(intf_thread_t *intf)
+{
+    struct filter_sys_t *p_state = intf->p_sys->mouse_only;
+    if (!p_state) {
+        return;
+    }
+    intf->p_sys->mouse_only = NULL;
+    filter_sys_destroy(p_state);
+    free(p_state);
+}
+
+// The interface thread's housekeeping after the commands of a wakeup are run
+static void intf_publish(intf_thread_t *intf)
+{
+    log_drain(intf);
+    latency_publish(intf);
+    counters_publish(intf);
+}
+
+static void *intf_run(void *data)
+{
+    intf_thread_t *intf = (intf_thread_t *) data;
+
+    for (;;) {
+        vlc_sem_wait(&intf->p_sys->wakeup);
+        commands_run(intf);
+        intf_publish(intf);
+        if (atomic_load(&intf->p_sys->stop)) {
+            break;
+        }
     }
+
+    return NULL;
 }
 
 static int OpenInterface(vlc_object_t *p_this)
 {
-    p_intf = (intf_thread_t*) p_this;
+    intf_thread_t *intf = (intf_thread_t*) p_this;
 
     print_version(p_this);
-    msg_Dbg(p_intf, "interface sub-plugin opened");
+    msg_Dbg(intf, "interface sub-plugin opened");
+
+    intf_sys_t *p_sys = malloc(sizeof(*p_sys));
+    if (!p_sys) {
+        return VLC_ENOMEM;
+    }
+    atomic_init(&p_sys->refs, 1);
+    atomic_init(&p_sys->stop, false);
+    ring_init(&p_sys->commands);
+    p_sys->deferred_log = var_InheritBool(intf, DEFERRED_LOG_CFG);
+    ring_init(&p_sys->log);
+    atomic_init(&p_sys->log_wakeup, false);
+    atomic_init(&p_sys->log_dropped, 0);
+    for (unsigned i = 0; i < LATENCY_STAGES; i ++) {
+        histogram_init(&p_sys->latency[i]);
+    }
+    atomic_init(&p_sys->latency_updated, false);
+    var_Create(intf, LATENCY_VAR, VLC_VAR_STRING);
+    p_sys->trace = NULL;
+    char *psz_trace = var_InheritString(intf, TRACE_FILE_CFG);
+    if (psz_trace) {
+        p_sys->trace = vlc_fopen(psz_trace, "wb");
+        if (!p_sys->trace || !trace_write_header(p_sys->trace)) {
+            msg_Err(intf, "failed to open the trace file %s", psz_trace);
+            if (p_sys->trace) {
+                fclose(p_sys->trace);
+                p_sys->trace = NULL;
+            }
+        }
+        free(psz_trace);
+    }
+#if 2 <= LIBVLC_VERSION_MAJOR && LIBVLC_VERSION_MAJOR <= 3
+    atomic_init(&p_sys->in_menu, false);
+#endif
+    atomic_init(&p_sys->observed_click_time, 0);
+    atomic_init(&p_sys->pause_vout, 0);
+    atomic_init(&p_sys->input_changes, 0);
+    p_sys->frame_pacing = var_InheritBool(intf, FRAME_PACING_CFG);
+    atomic_init(&p_sys->resume_time, 0);
+    p_sys->rollback.valid = false;
+    p_sys->normal_rate = 1.f;
+    p_sys->coalesce.window = var_InheritInteger(intf, COALESCE_WINDOW_CFG) * 1000;
+    p_sys->coalesce.end = 0;
+    p_sys->coalesce.pending = 0;
+    counters_create(intf, p_sys);
+    p_sys->wheel = timer_wheel_acquire();
+    timer_wheel_entry_init(&p_sys->counters_timer, counters_timer_callback, p_sys);
+    timer_wheel_entry_init(&p_sys->coalesce.timer, coalesce_timer_callback, intf);
+    // the window needs the wheel to end
+    if (!p_sys->wheel) {
+        p_sys->coalesce.window = 0;
+    }
+    vlc_mutex_init(&p_sys->vouts_lock);
+    p_sys->vouts = NULL;
+    p_sys->vouts_count = 0;
+    p_sys->vouts_capacity = 0;
+    p_sys->filters = NULL;
+    vlc_sem_init(&p_sys->wakeup, 0);
+    intf->p_sys = p_sys;
+    p_sys->mouse_only = NULL;
+    p_sys->pool = NULL;
+    p_sys->pool_open = true;
+    if (var_InheritBool(intf, MOUSE_ONLY_CFG)) {
+        mouse_only_init(intf);
+    }
+    player_watch_init(intf);
+
+    if (_vlc_clone(&p_sys->thread, intf_run, intf, VLC_THREAD_PRIORITY_LOW)) {
+        msg_Err(intf, "failed to create a thread");
+        player_watch_destroy(intf);
+        mouse_only_destroy(intf);
+        if (p_sys->wheel) {
+            timer_wheel_release(p_sys->wheel);
+        }
+        _vlc_mutex_destroy(&p_sys->vouts_lock);
+        _vlc_sem_destroy(&p_sys->wakeup);
+        var_Destroy(intf, LATENCY_VAR);
+        counters_destroy(intf);
+        if (p_sys->trace) {
+            fclose(p_sys->trace);
+        }
+        free(p_sys);
+        return VLC_EGENERIC;
+    }
+
+    vlc_mutex_lock(&intf_lock);
+    var_Create(_libvlc(p_this), INTF_VAR, VLC_VAR_ADDRESS);
+    var_SetAddress(_libvlc(p_this), INTF_VAR, p_sys);
+    vlc_mutex_unlock(&intf_lock);
 
     return VLC_SUCCESS;
 }
 
 static void CloseInterface(vlc_object_t *p_this)
 {
+    intf_thread_t *intf = (intf_thread_t*) p_this;
+    intf_sys_t *p_sys = intf->p_sys;
+
     msg_Dbg(p_this, "interface sub-plugin closed");
 
-    p_intf = NULL;
+    // the filters that are still open keep their reference, but no new ones
+    // will find us
+    vlc_mutex_lock(&intf_lock);
+    var_Destroy(_libvlc(p_this), INTF_VAR);
+    vlc_mutex_unlock(&intf_lock);
+
+    atomic_store(&p_sys->stop, true);
+    vlc_sem_post(&p_sys->wakeup);
+    vlc_join(p_sys->thread, NULL);
+
+    // the interface thread opens the coalescing windows
+    if (p_sys->wheel) {
+        timer_wheel_cancel(p_sys->wheel, &p_sys->coalesce.timer);
+    }
+
+    // stops the counters timer along with the last vout
+    player_watch_destroy(intf);
+    if (p_sys->wheel) {
+        timer_wheel_release(p_sys->wheel);
+    }
+    mouse_only_destroy(intf);
+    pool_drain(intf);
+
+    char buf[2048];
+    latency_format(intf, buf, sizeof(buf));
+    msg_Dbg(intf, "click latency:\n%s", buf);
+    var_Destroy(intf, LATENCY_VAR);
+    counters_destroy(intf);
+
+    intf_sys_release(p_sys);
 }
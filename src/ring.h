@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * ring.h : Bounded lock-free multi-producer single-consumer queue
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef RING_H
+#define RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// VLC's header instead of <stdatomic.h>, as it emulates the C11 atomics on the
+// pre-C11 compilers VLC 2.1 and 2.2 are built with. The bench gets it from
+// tools/shim
+#include <vlc_atomic.h>
+
+#define RING_SIZE 256 // must be a power of two
+
+// A bounded lock-free multi-producer single-consumer queue of raw records,
+// that is, a tag and a few integers, which are interpreted by the consumer.
+// Based on Dmitry Vyukov's bounded MPMC queue.
+struct ring {
+    atomic_uint head;
+    unsigned tail;
+    struct {
+        atomic_uint seq;
+        int tag;
+        int64_t args[4];
+    } entries[RING_SIZE];
+};
+
+static inline void ring_init(struct ring *p_ring)
+{
+    atomic_init(&p_ring->head, 0);
+    p_ring->tail = 0;
+    for (unsigned i = 0; i < RING_SIZE; i ++) {
+        atomic_init(&p_ring->entries[i].seq, i);
+    }
+}
+
+// can be called from any thread. returns false if the ring is full
+static inline bool ring_push(struct ring *p_ring, int tag, int64_t a, int64_t b, int64_t c, int64_t d)
+{
+    unsigned pos = atomic_load_explicit(&p_ring->head, memory_order_relaxed);
+    for (;;) {
+        unsigned seq = atomic_load_explicit(&p_ring->entries[pos & (RING_SIZE-1)].seq,
+                                            memory_order_acquire);
+        int diff = (int)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&p_ring->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&p_ring->head, memory_order_relaxed);
+        }
+    }
+
+    unsigned i = pos & (RING_SIZE-1);
+    p_ring->entries[i].tag = tag;
+    p_ring->entries[i].args[0] = a;
+    p_ring->entries[i].args[1] = b;
+    p_ring->entries[i].args[2] = c;
+    p_ring->entries[i].args[3] = d;
+    atomic_store_explicit(&p_ring->entries[i].seq, pos + 1, memory_order_release);
+
+    return true;
+}
+
+// must be called from a single thread only. returns false if the ring is empty
+static inline bool ring_pop(struct ring *p_ring, int *tag, int64_t args[4])
+{
+    unsigned pos = p_ring->tail;
+    unsigned i = pos & (RING_SIZE-1);
+    unsigned seq = atomic_load_explicit(&p_ring->entries[i].seq, memory_order_acquire);
+    if ((int)(seq - (pos + 1)) < 0) {
+        return false;
+    }
+
+    *tag = p_ring->entries[i].tag;
+    for (int j = 0; j < 4; j ++) {
+        args[j] = p_ring->entries[i].args[j];
+    }
+    atomic_store_explicit(&p_ring->entries[i].seq, pos + RING_SIZE, memory_order_release);
+    p_ring->tail = pos + 1;
+
+    return true;
+}
+
+#endif
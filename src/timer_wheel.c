@@ -0,0 +1,291 @@
+/*****************************************************************************
+ * timer_wheel.c : Timer wheel shared by all filter instances
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/libvlc_version.h>
+#include "timer_wheel.h"
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include "vlc_compat.h"
+
+#define TIMER_WHEEL_TICK_US 1000
+#define TIMER_WHEEL_SLOTS 256 // must be a power of two
+
+struct timer_wheel {
+    vlc_mutex_t lock;
+    // wakes the wheel thread up
+    vlc_cond_t wait;
+    // signalled whenever a callback returns
+    vlc_cond_t done;
+    vlc_thread_t thread;
+    bool stop;
+    // time of tick 0
+    int64_t origin;
+    // the last tick that has been processed
+    uint64_t tick;
+    // the tick the wheel thread sleeps until, UINT64_MAX if there is nothing
+    // to wait for. No entry is due before it.
+    uint64_t wake_tick;
+    unsigned armed_count;
+    struct timer_wheel_entry *slots[TIMER_WHEEL_SLOTS];
+    // the entry whose callback is running
+    struct timer_wheel_entry *running;
+    // protected by wheel_lock
+    unsigned refs;
+};
+
+static vlc_mutex_t wheel_lock = VLC_STATIC_MUTEX;
+static struct timer_wheel *wheel = NULL;
+
+static uint64_t now_tick(struct timer_wheel *p_wheel)
+{
+    int64_t elapsed = _now_us() - p_wheel->origin;
+    return elapsed > 0 ? (uint64_t) elapsed / TIMER_WHEEL_TICK_US : 0;
+}
+
+static void entry_link(struct timer_wheel *p_wheel, struct timer_wheel_entry *p_entry)
+{
+    struct timer_wheel_entry **pp_slot = &p_wheel->slots[p_entry->expires & (TIMER_WHEEL_SLOTS-1)];
+    p_entry->p_prev = NULL;
+    p_entry->p_next = *pp_slot;
+    if (*pp_slot) {
+        (*pp_slot)->p_prev = p_entry;
+    }
+    *pp_slot = p_entry;
+    p_entry->armed = true;
+    p_wheel->armed_count ++;
+}
+
+static void entry_unlink(struct timer_wheel *p_wheel, struct timer_wheel_entry *p_entry)
+{
+    if (p_entry->p_prev) {
+        p_entry->p_prev->p_next = p_entry->p_next;
+    } else {
+        p_wheel->slots[p_entry->expires & (TIMER_WHEEL_SLOTS-1)] = p_entry->p_next;
+    }
+    if (p_entry->p_next) {
+        p_entry->p_next->p_prev = p_entry->p_prev;
+    }
+    p_entry->armed = false;
+    p_wheel->armed_count --;
+}
+
+// the earliest tick an entry is due on. Stops at the first entry due within
+// the coming revolution, otherwise every slot has been looked at, so the
+// earliest of the later revolutions is known as well.
+static uint64_t next_tick(struct timer_wheel *p_wheel)
+{
+    uint64_t earliest = UINT64_MAX;
+    for (uint64_t tick = p_wheel->tick + 1; tick <= p_wheel->tick + TIMER_WHEEL_SLOTS; tick ++) {
+        for (struct timer_wheel_entry *p_entry = p_wheel->slots[tick & (TIMER_WHEEL_SLOTS-1)];
+             p_entry; p_entry = p_entry->p_next) {
+            if (p_entry->expires == tick) {
+                return tick;
+            }
+            if (p_entry->expires < earliest) {
+                earliest = p_entry->expires;
+            }
+        }
+    }
+    return earliest;
+}
+
+static void *timer_wheel_run(void *data)
+{
+    struct timer_wheel *p_wheel = (struct timer_wheel *) data;
+
+    vlc_mutex_lock(&p_wheel->lock);
+    while (!p_wheel->stop) {
+        const uint64_t now = now_tick(p_wheel);
+        // nothing is due before wake_tick, so skip the empty ticks up to it
+        // instead of walking them one by one after a long sleep
+        if (p_wheel->armed_count > 0 && p_wheel->wake_tick - 1 > p_wheel->tick) {
+            p_wheel->tick = p_wheel->wake_tick - 1 < now ? p_wheel->wake_tick - 1 : now;
+        }
+        while (p_wheel->tick < now && p_wheel->armed_count > 0) {
+            p_wheel->tick ++;
+            struct timer_wheel_entry **pp_slot = &p_wheel->slots[p_wheel->tick & (TIMER_WHEEL_SLOTS-1)];
+            struct timer_wheel_entry *p_entry = *pp_slot;
+            while (p_entry) {
+                // entries of the later revolutions stay in the slot
+                if (p_entry->expires > p_wheel->tick) {
+                    p_entry = p_entry->p_next;
+                    continue;
+                }
+                entry_unlink(p_wheel, p_entry);
+                p_wheel->running = p_entry;
+                vlc_mutex_unlock(&p_wheel->lock);
+                p_entry->callback(p_entry->data);
+                vlc_mutex_lock(&p_wheel->lock);
+                p_wheel->running = NULL;
+                vlc_cond_broadcast(&p_wheel->done);
+                // the slot might have changed while we were unlocked
+                p_entry = *pp_slot;
+            }
+        }
+
+        if (p_wheel->armed_count == 0) {
+            p_wheel->wake_tick = UINT64_MAX;
+            vlc_cond_wait(&p_wheel->wait, &p_wheel->lock);
+        } else {
+            // when woken up early, wake_tick is still ahead and no later
+            // than any entry, so it only needs looking for once reached
+            if (p_wheel->wake_tick <= p_wheel->tick) {
+                p_wheel->wake_tick = next_tick(p_wheel);
+            }
+            int64_t deadline = p_wheel->origin + (int64_t) p_wheel->wake_tick * TIMER_WHEEL_TICK_US;
+            vlc_cond_timedwait(&p_wheel->wait, &p_wheel->lock, _tick_from_us(deadline));
+        }
+    }
+    vlc_mutex_unlock(&p_wheel->lock);
+
+    return NULL;
+}
+
+struct timer_wheel *timer_wheel_acquire(void)
+{
+    vlc_mutex_lock(&wheel_lock);
+    if (wheel) {
+        wheel->refs ++;
+        vlc_mutex_unlock(&wheel_lock);
+        return wheel;
+    }
+
+    struct timer_wheel *p_wheel = malloc(sizeof(*p_wheel));
+    if (!p_wheel) {
+        vlc_mutex_unlock(&wheel_lock);
+        return NULL;
+    }
+    vlc_mutex_init(&p_wheel->lock);
+    vlc_cond_init(&p_wheel->wait);
+    vlc_cond_init(&p_wheel->done);
+    p_wheel->stop = false;
+    p_wheel->origin = _now_us();
+    p_wheel->tick = 0;
+    p_wheel->wake_tick = UINT64_MAX;
+    p_wheel->armed_count = 0;
+    for (unsigned i = 0; i < TIMER_WHEEL_SLOTS; i ++) {
+        p_wheel->slots[i] = NULL;
+    }
+    p_wheel->running = NULL;
+    p_wheel->refs = 1;
+
+    if (_vlc_clone(&p_wheel->thread, timer_wheel_run, p_wheel, VLC_THREAD_PRIORITY_INPUT)) {
+        _vlc_cond_destroy(&p_wheel->done);
+        _vlc_cond_destroy(&p_wheel->wait);
+        _vlc_mutex_destroy(&p_wheel->lock);
+        free(p_wheel);
+        vlc_mutex_unlock(&wheel_lock);
+        return NULL;
+    }
+
+    wheel = p_wheel;
+    vlc_mutex_unlock(&wheel_lock);
+
+    return p_wheel;
+}
+
+void timer_wheel_release(struct timer_wheel *p_wheel)
+{
+    vlc_mutex_lock(&wheel_lock);
+    if (--p_wheel->refs > 0) {
+        vlc_mutex_unlock(&wheel_lock);
+        return;
+    }
+    wheel = NULL;
+    vlc_mutex_unlock(&wheel_lock);
+
+    vlc_mutex_lock(&p_wheel->lock);
+    p_wheel->stop = true;
+    vlc_cond_signal(&p_wheel->wait);
+    vlc_mutex_unlock(&p_wheel->lock);
+    vlc_join(p_wheel->thread, NULL);
+
+    _vlc_cond_destroy(&p_wheel->done);
+    _vlc_cond_destroy(&p_wheel->wait);
+    _vlc_mutex_destroy(&p_wheel->lock);
+    free(p_wheel);
+}
+
+void timer_wheel_entry_init(struct timer_wheel_entry *p_entry, void (*callback)(void *data), void *data)
+{
+    p_entry->p_prev = NULL;
+    p_entry->p_next = NULL;
+    p_entry->expires = 0;
+    p_entry->armed = false;
+    p_entry->callback = callback;
+    p_entry->data = data;
+}
+
+void timer_wheel_schedule(struct timer_wheel *p_wheel, struct timer_wheel_entry *p_entry, int64_t deadline)
+{
+    vlc_mutex_lock(&p_wheel->lock);
+    if (p_entry->armed) {
+        entry_unlink(p_wheel, p_entry);
+    }
+    if (p_wheel->armed_count == 0) {
+        // the wheel thread doesn't advance while there is nothing to wait
+        // for, so catch it up instead of having it walk the idle ticks
+        p_wheel->tick = now_tick(p_wheel);
+    }
+
+    // round up, so that the entry never fires early
+    int64_t elapsed = deadline - p_wheel->origin;
+    uint64_t expires = elapsed > 0 ? ((uint64_t) elapsed + TIMER_WHEEL_TICK_US - 1) / TIMER_WHEEL_TICK_US : 0;
+    p_entry->expires = expires > p_wheel->tick ? expires : p_wheel->tick + 1;
+    entry_link(p_wheel, p_entry);
+
+    const bool wake = p_entry->expires < p_wheel->wake_tick;
+    if (wake) {
+        p_wheel->wake_tick = p_entry->expires;
+    }
+    vlc_mutex_unlock(&p_wheel->lock);
+    // after unlocking, so that the wheel thread doesn't wake up only to wait
+    // for the lock
+    if (wake) {
+        vlc_cond_signal(&p_wheel->wait);
+    }
+}
+
+void timer_wheel_cancel(struct timer_wheel *p_wheel, struct timer_wheel_entry *p_entry)
+{
+    vlc_mutex_lock(&p_wheel->lock);
+    while (p_wheel->running == p_entry) {
+        vlc_cond_wait(&p_wheel->done, &p_wheel->lock);
+    }
+    // the callback might have rescheduled the entry
+    if (p_entry->armed) {
+        entry_unlink(p_wheel, p_entry);
+    }
+    vlc_mutex_unlock(&p_wheel->lock);
+}
@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * timer_wheel.h : Timer wheel shared by all filter instances
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A hashed timer wheel with millisecond ticks, run by a single thread that is
+// shared by every filter instance in the process. Scheduling and cancelling
+// an entry are O(1), and the thread only wakes up when an entry is due
+// instead of every tick.
+
+struct timer_wheel;
+
+// embedded into its owner, so that scheduling doesn't allocate
+struct timer_wheel_entry {
+    // intrusive list of the entries in the same slot
+    struct timer_wheel_entry *p_prev;
+    struct timer_wheel_entry *p_next;
+    // the tick the entry is due on
+    uint64_t expires;
+    bool armed;
+    void (*callback)(void *data);
+    void *data;
+};
+
+// Returns the process-wide wheel, starting it on the first call. Every call
+// must be paired with timer_wheel_release(). Returns NULL on failure.
+struct timer_wheel *timer_wheel_acquire(void);
+
+// Stops the wheel once the last user releases it.
+void timer_wheel_release(struct timer_wheel *p_wheel);
+
+void timer_wheel_entry_init(struct timer_wheel_entry *p_entry, void (*callback)(void *data), void *data);
+
+// (Re)schedules the entry to call its callback on the wheel thread at the
+// deadline, which is in microseconds of the VLC clock. The callback can
+// reschedule its own entry.
+void timer_wheel_schedule(struct timer_wheel *p_wheel, struct timer_wheel_entry *p_entry, int64_t deadline);
+
+// Unschedules the entry. If its callback is running, waits for it to return,
+// so it must not be called from the callback itself.
+void timer_wheel_cancel(struct timer_wheel *p_wheel, struct timer_wheel_entry *p_entry);
+
+#endif
@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * trace.h : Binary trace of the mouse events the plugin receives
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "click_logic.h"
+#include "gesture.h"
+
+// A trace is the TRACE_MAGIC header followed by fixed-size records, in the
+// byte order of the machine that has recorded it. A config record precedes
+// the mouse records it applies to. When gesture bindings replace the click
+// logic, the config record has TRACE_CONFIG_GESTURES set and is directly
+// followed by a gestures record with the bindings.
+
+#define TRACE_MAGIC "PCTRACE1"
+#define TRACE_MAGIC_SIZE 8
+
+enum trace_record_type {
+    TRACE_RECORD_CONFIG = 1,
+    TRACE_RECORD_MOUSE = 2,
+    TRACE_RECORD_GESTURES = 3,
+};
+
+enum trace_config_flag {
+    TRACE_CONFIG_ENABLE_DOUBLE_CLICK_DELAY = 1 << 0,
+    TRACE_CONFIG_IGNORE_DOUBLE_CLICK = 1 << 1,
+    TRACE_CONFIG_DISABLE_FS_TOGGLE = 1 << 2,
+    TRACE_CONFIG_DISABLE_CONTEXT_MENU_TOGGLE = 1 << 3,
+    TRACE_CONFIG_DOUBLE_CLICK_IS_CLICK = 1 << 4,
+    TRACE_CONFIG_FS_TOGGLE_PRESSES_LEFT = 1 << 5,
+    TRACE_CONFIG_SPECULATIVE = 1 << 6,
+    TRACE_CONFIG_ADAPTIVE_DOUBLE_CLICK_DELAY = 1 << 7,
+    TRACE_CONFIG_GESTURES = 1 << 8,
+};
+
+// the actions of a button's gestures are packed into 4 bits each
+_Static_assert(GESTURE_ACTIONS <= 16 && GESTURES * 4 <= 32,
+               "the gesture bindings don't fit into a trace record");
+
+struct trace_record {
+    uint32_t type;
+    uint32_t reserved;
+    int64_t time; // monotonic, in microseconds
+    union {
+        struct {
+            int32_t mouse_button;
+            int32_t fs_mouse_button;
+            int32_t context_menu_mouse_button;
+            int32_t double_click_delay;
+            uint32_t flags;
+            // the double click interval learned in a previous session, 0 if
+            // none, see click_machine.learned_delay
+            int32_t learned_double_click_delay;
+        } config;
+        struct {
+            // enum gesture_action of every gesture of a button
+            uint32_t actions[GESTURE_BUTTONS];
+        } gestures;
+        struct {
+            int32_t old_x, old_y, old_pressed, old_double_click;
+            int32_t new_x, new_y, new_pressed, new_double_click;
+        } mouse;
+    } u;
+};
+
+static inline bool trace_write_header(FILE *stream)
+{
+    return fwrite(TRACE_MAGIC, TRACE_MAGIC_SIZE, 1, stream) == 1;
+}
+
+static inline bool trace_read_header(FILE *stream)
+{
+    char magic[TRACE_MAGIC_SIZE];
+    return fread(magic, sizeof(magic), 1, stream) == 1 &&
+           memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_SIZE) == 0;
+}
+
+// Fills recs with the config record, and the gestures record if the gesture
+// table isn't empty. Returns the number of records filled.
+static inline size_t trace_config_to_records(const struct click_config *cfg, int64_t learned_delay,
+                                             const struct gesture_table *gestures, int64_t time,
+                                             struct trace_record recs[2])
+{
+    struct trace_record *p_rec = &recs[0];
+    const bool has_gestures = !gesture_table_is_empty(gestures);
+    memset(p_rec, 0, sizeof(*p_rec));
+    p_rec->type = TRACE_RECORD_CONFIG;
+    p_rec->time = time;
+    p_rec->u.config.mouse_button = cfg->mouse_button;
+    p_rec->u.config.fs_mouse_button = cfg->fs_mouse_button;
+    p_rec->u.config.context_menu_mouse_button = cfg->context_menu_mouse_button;
+    p_rec->u.config.double_click_delay = cfg->double_click_delay;
+    p_rec->u.config.flags =
+            (cfg->enable_double_click_delay ? TRACE_CONFIG_ENABLE_DOUBLE_CLICK_DELAY : 0) |
+            (cfg->ignore_double_click ? TRACE_CONFIG_IGNORE_DOUBLE_CLICK : 0) |
+            (cfg->disable_fs_toggle ? TRACE_CONFIG_DISABLE_FS_TOGGLE : 0) |
+            (cfg->disable_context_menu_toggle ? TRACE_CONFIG_DISABLE_CONTEXT_MENU_TOGGLE : 0) |
+            (cfg->double_click_is_click ? TRACE_CONFIG_DOUBLE_CLICK_IS_CLICK : 0) |
+            (cfg->fs_toggle_presses_left ? TRACE_CONFIG_FS_TOGGLE_PRESSES_LEFT : 0) |
+            (cfg->speculative ? TRACE_CONFIG_SPECULATIVE : 0) |
+            (cfg->adaptive_double_click_delay ? TRACE_CONFIG_ADAPTIVE_DOUBLE_CLICK_DELAY : 0) |
+            (has_gestures ? TRACE_CONFIG_GESTURES : 0);
+    p_rec->u.config.learned_double_click_delay = learned_delay;
+    if (!has_gestures) {
+        return 1;
+    }
+
+    p_rec = &recs[1];
+    memset(p_rec, 0, sizeof(*p_rec));
+    p_rec->type = TRACE_RECORD_GESTURES;
+    p_rec->time = time;
+    for (int b = 0; b < GESTURE_BUTTONS; b ++) {
+        for (int g = 0; g < GESTURES; g ++) {
+            p_rec->u.gestures.actions[b] |= (uint32_t) gestures->actions[b][g] << (g * 4);
+        }
+    }
+    return 2;
+}
+
+static inline void trace_record_to_config(const struct trace_record *p_rec, struct click_config *cfg,
+                                          int64_t *p_learned_delay)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->mouse_button = p_rec->u.config.mouse_button;
+    cfg->fs_mouse_button = p_rec->u.config.fs_mouse_button;
+    cfg->context_menu_mouse_button = p_rec->u.config.context_menu_mouse_button;
+    cfg->double_click_delay = p_rec->u.config.double_click_delay;
+    const uint32_t flags = p_rec->u.config.flags;
+    cfg->enable_double_click_delay = flags & TRACE_CONFIG_ENABLE_DOUBLE_CLICK_DELAY;
+    cfg->ignore_double_click = flags & TRACE_CONFIG_IGNORE_DOUBLE_CLICK;
+    cfg->disable_fs_toggle = flags & TRACE_CONFIG_DISABLE_FS_TOGGLE;
+    cfg->disable_context_menu_toggle = flags & TRACE_CONFIG_DISABLE_CONTEXT_MENU_TOGGLE;
+    cfg->double_click_is_click = flags & TRACE_CONFIG_DOUBLE_CLICK_IS_CLICK;
+    cfg->fs_toggle_presses_left = flags & TRACE_CONFIG_FS_TOGGLE_PRESSES_LEFT;
+    cfg->speculative = flags & TRACE_CONFIG_SPECULATIVE;
+    cfg->adaptive_double_click_delay = flags & TRACE_CONFIG_ADAPTIVE_DOUBLE_CLICK_DELAY;
+    *p_learned_delay = p_rec->u.config.learned_double_click_delay;
+}
+
+// returns false if the record has an action this build doesn't know
+static inline bool trace_record_to_gestures(const struct trace_record *p_rec, struct gesture_table *gestures)
+{
+    memset(gestures, 0, sizeof(*gestures));
+    for (int b = 0; b < GESTURE_BUTTONS; b ++) {
+        for (int g = 0; g < GESTURES; g ++) {
+            const unsigned action = (p_rec->u.gestures.actions[b] >> (g * 4)) & 0xf;
+            if (action >= GESTURE_ACTIONS) {
+                memset(gestures, 0, sizeof(*gestures));
+                return false;
+            }
+            gestures->actions[b][g] = action;
+        }
+    }
+    gesture_table_finish(gestures);
+    return true;
+}
+
+// a single fwrite() per record, so that records written from different
+// threads don't interleave
+static inline bool trace_write(FILE *stream, const struct trace_record *p_rec)
+{
+    return fwrite(p_rec, sizeof(*p_rec), 1, stream) == 1;
+}
+
+// the same for a few records that have to stay together
+static inline bool trace_write_n(FILE *stream, const struct trace_record *recs, size_t count)
+{
+    return fwrite(recs, sizeof(*recs), count, stream) == count;
+}
+
+static inline bool trace_read(FILE *stream, struct trace_record *p_rec)
+{
+    return fread(p_rec, sizeof(*p_rec), 1, stream) == 1;
+}
+
+#endif
@@ -0,0 +1,108 @@
+/*****************************************************************************
+ * vlc_compat.h : Wrappers over the VLC API differences between versions
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_COMPAT_H
+#define VLC_COMPAT_H
+
+#include <vlc/libvlc_version.h>
+
+// VLC 4.0 removed the thread priority argument of vlc_clone() and made
+// mutexes, condition variables and semaphores not require destruction
+#if LIBVLC_VERSION_MAJOR >= 4
+# define _vlc_clone(th, entry, data, priority) \
+    vlc_clone(th, entry, data)
+# define _vlc_mutex_destroy(mutex) \
+    ((void)(mutex))
+# define _vlc_cond_destroy(cond) \
+    ((void)(cond))
+# define _vlc_sem_destroy(sem) \
+    ((void)(sem))
+#else
+# define _vlc_clone(th, entry, data, priority) \
+    vlc_clone(th, entry, data, priority)
+# define _vlc_mutex_destroy(mutex) \
+    vlc_mutex_destroy(mutex)
+# define _vlc_cond_destroy(cond) \
+    vlc_cond_destroy(cond)
+# define _vlc_sem_destroy(sem) \
+    vlc_sem_destroy(sem)
+#endif
+
+// VLC 4.0 removed the object argument of config_PutInt()
+#if LIBVLC_VERSION_MAJOR >= 4
+# define _config_PutInt(p_obj, name, value) \
+    config_PutInt(name, value)
+#else
+# define _config_PutInt(p_obj, name, value) \
+    config_PutInt(p_obj, name, value)
+#endif
+
+// VLC 4.0 replaced mdate() with vlc_tick_now() and made the ticks a type of
+// their own
+#if LIBVLC_VERSION_MAJOR >= 4
+# define _now_us() \
+    US_FROM_VLC_TICK(vlc_tick_now())
+# define _tick_from_us(us) \
+    VLC_TICK_FROM_US(us)
+#else
+# define _now_us() \
+    mdate()
+# define _tick_from_us(us) \
+    (us)
+#endif
+
+// VLC 4.0 made the timestamps vlc_tick_t. VLC 2 and 3 pictures are dated in
+// the system clock, VLC 4 ones in the stream clock
+#if LIBVLC_VERSION_MAJOR >= 4
+# define _picture_date_us(p_pic) \
+    US_FROM_VLC_TICK((p_pic)->date)
+#else
+# define _picture_date_us(p_pic) \
+    ((p_pic)->date)
+#endif
+
+// VLC 3.0 moved the common object members into obj, VLC 4.0 made them private
+#if LIBVLC_VERSION_MAJOR >= 4
+# define _vlc_object_parent(p_obj) \
+    vlc_object_parent(p_obj)
+#elif LIBVLC_VERSION_MAJOR == 3
+# define _vlc_object_parent(p_obj) \
+    ((p_obj)->obj.parent)
+#else
+# define _vlc_object_parent(p_obj) \
+    ((p_obj)->p_parent)
+#endif
+
+#if LIBVLC_VERSION_MAJOR >= 4
+# define _libvlc(p_obj) \
+    vlc_object_instance(p_obj)
+#elif LIBVLC_VERSION_MAJOR == 3
+# define _libvlc(p_obj) \
+    ((p_obj)->obj.libvlc)
+#else
+# define _libvlc(p_obj) \
+    ((p_obj)->p_libvlc)
+#endif
+
+#endif
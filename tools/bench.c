@@ -0,0 +1,578 @@
+/*****************************************************************************
+ * bench.c : Microbenchmarks of the mouse event path in a stand-in of VLC
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "shim.h"
+
+// the plugin itself, so that its callbacks can be called directly
+#include "pause_click.c"
+
+// Counts the heap allocations and frees of the event path when linked with
+// -Wl,--wrap for every function of the allocator family: the ones made while
+// the vout thread is in the plugin's callbacks or the interface thread runs
+// the commands, pause/play included, and all the ones of the timer wheel's
+// thread
+#ifdef BENCH_COUNT_ALLOCS
+static atomic_uint_least64_t allocations;
+static atomic_uint_least64_t frees;
+static _Thread_local bool counting = false;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__real_reallocarray(void *ptr, size_t n, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+int __real_posix_memalign(void **pp, size_t alignment, size_t size);
+void *__real_memalign(size_t alignment, size_t size);
+void *__real_valloc(size_t size);
+char *__real_strdup(const char *s);
+char *__real_strndup(const char *s, size_t n);
+int __real_vasprintf(char **pp, const char *format, va_list ap);
+void __real_free(void *ptr);
+
+static void count_allocation(void)
+{
+    if (counting) {
+        atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    }
+}
+
+void *__wrap_malloc(size_t size)
+{
+    count_allocation();
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    count_allocation();
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    count_allocation();
+    return __real_realloc(ptr, size);
+}
+
+void *__wrap_reallocarray(void *ptr, size_t n, size_t size)
+{
+    count_allocation();
+    return __real_reallocarray(ptr, n, size);
+}
+
+void *__wrap_aligned_alloc(size_t alignment, size_t size)
+{
+    count_allocation();
+    return __real_aligned_alloc(alignment, size);
+}
+
+int __wrap_posix_memalign(void **pp, size_t alignment, size_t size)
+{
+    count_allocation();
+    return __real_posix_memalign(pp, alignment, size);
+}
+
+void *__wrap_memalign(size_t alignment, size_t size)
+{
+    count_allocation();
+    return __real_memalign(alignment, size);
+}
+
+void *__wrap_valloc(size_t size)
+{
+    count_allocation();
+    return __real_valloc(size);
+}
+
+// libc allocates these on its own, without going through the wrapped malloc
+char *__wrap_strdup(const char *s)
+{
+    count_allocation();
+    return __real_strdup(s);
+}
+
+char *__wrap_strndup(const char *s, size_t n)
+{
+    count_allocation();
+    return __real_strndup(s, n);
+}
+
+int __wrap_vasprintf(char **pp, const char *format, va_list ap)
+{
+    count_allocation();
+    return __real_vasprintf(pp, format, ap);
+}
+
+int __wrap_asprintf(char **pp, const char *format, ...)
+{
+    count_allocation();
+    va_list ap;
+    va_start(ap, format);
+    const int ret = __real_vasprintf(pp, format, ap);
+    va_end(ap);
+    return ret;
+}
+
+// a free on the event path means something has been allocated for it
+// somewhere, if not on it
+void __wrap_free(void *ptr)
+{
+    if (counting && ptr) {
+        atomic_fetch_add_explicit(&frees, 1, memory_order_relaxed);
+    }
+    __real_free(ptr);
+}
+
+static void count_thread(void)
+{
+    counting = true;
+}
+
+# define COUNT_BEGIN() (counting = true)
+# define COUNT_END() (counting = false)
+#else
+# define COUNT_BEGIN() ((void) 0)
+# define COUNT_END() ((void) 0)
+#endif
+
+// a synthetic mouse event
+struct event {
+    int64_t time;
+    vlc_mouse_t old;
+    vlc_mouse_t new;
+};
+
+struct scenario {
+    const char *name;
+    // puts the settings of the scenario into the config
+    void (*setup)(void);
+    // the i-th event of the endless stream
+    void (*event)(uint64_t i, struct event *p_ev);
+    // the most time per event the vout thread may spend, in nanoseconds,
+    // about twice what it takes on a desktop machine
+    int64_t budget;
+};
+
+#define LEFT (1 << MOUSE_BUTTON_LEFT)
+#define CENTER (1 << MOUSE_BUTTON_CENTER)
+#define RIGHT (1 << MOUSE_BUTTON_RIGHT)
+#define WHEEL_UP (1 << MOUSE_BUTTON_WHEEL_UP)
+
+static void setup_default(void)
+{
+}
+
+static void setup_double_click(void)
+{
+    config_PutInt(IGNORE_DOUBLE_CLICK_CFG, 1);
+}
+
+// the indexes into mouse_button_values
+#define CFG_MOUSE_BUTTON_CENTER 2
+
+static void setup_remap(void)
+{
+    config_PutInt(FS_TOGGLE_MOUSE_BUTTON_CFG, CFG_MOUSE_BUTTON_CENTER);
+    config_PutInt(DISABLE_CONTEXT_MENU_TOGGLE_CFG, 1);
+    config_PutInt(CONTEXT_MENU_TOGGLE_MOUSE_BUTTON_CFG, CFG_MOUSE_BUTTON_CENTER);
+}
+
+#define GESTURES "left:click=pause,left:double=fullscreen,wheel-up:press=seek-forward"
+
+static void setup_gestures(void)
+{
+    config_PutPsz(GESTURES_CFG, GESTURES);
+}
+
+#define HOLD_GESTURES "left:hold=speed2x,right:click=pause"
+
+static void setup_hold_click(void)
+{
+    config_PutPsz(GESTURES_CFG, HOLD_GESTURES);
+}
+
+static void mouse_set(vlc_mouse_t *p_mouse, int x, int pressed, bool double_click)
+{
+    vlc_mouse_Init(p_mouse);
+    p_mouse->i_x = x;
+    p_mouse->i_pressed = pressed;
+    p_mouse->b_double_click = double_click;
+}
+
+// single clicks a second apart, every event is a press
+static void event_press(uint64_t i, struct event *p_ev)
+{
+    p_ev->time = (int64_t) i * 1000000;
+    mouse_set(&p_ev->old, 0, 0, false);
+    mouse_set(&p_ev->new, 0, LEFT, false);
+}
+
+// button releases, which the plugin returns early on
+static void event_release(uint64_t i, struct event *p_ev)
+{
+    p_ev->time = (int64_t) i * 1000;
+    mouse_set(&p_ev->old, 0, LEFT, false);
+    mouse_set(&p_ev->new, 0, 0, false);
+}
+
+// moving the mouse with the button held
+static void event_drag(uint64_t i, struct event *p_ev)
+{
+    p_ev->time = (int64_t) i * 1000;
+    mouse_set(&p_ev->old, (int) (i % 1024), LEFT, false);
+    mouse_set(&p_ev->new, (int) ((i + 1) % 1024), LEFT, false);
+}
+
+// a sustained drag of a 8 kHz mouse, pressed once and then moved with the
+// button held for the rest of the run
+static void event_drag_8khz(uint64_t i, struct event *p_ev)
+{
+    p_ev->time = (int64_t) i * 125;
+    mouse_set(&p_ev->old, (int) (i % 1024), i ? LEFT : 0, false);
+    mouse_set(&p_ev->new, (int) ((i + 1) % 1024), LEFT, false);
+}
+
+// press, release, press, release of a double click, one a second
+static void event_double_click(uint64_t i, struct event *p_ev)
+{
+    static const int64_t offsets[4] = {0, 50000, 120000, 170000};
+    p_ev->time = (int64_t) (i / 4) * 1000000 + offsets[i % 4];
+    const bool press = i % 2 == 0;
+    mouse_set(&p_ev->old, 0, press ? 0 : LEFT, false);
+    mouse_set(&p_ev->new, 0, press ? LEFT : 0, i % 4 == 2);
+}
+
+// the middle button toggling fullscreen and the context menu, the right one
+// suppressed
+static void event_remap(uint64_t i, struct event *p_ev)
+{
+    p_ev->time = (int64_t) i * 500000;
+    mouse_set(&p_ev->old, 0, 0, false);
+    mouse_set(&p_ev->new, 0, i % 2 ? RIGHT : CENTER, false);
+}
+
+// a click, a wheel notch and a double click every second, through the
+// gesture bindings
+static void event_gestures(uint64_t i, struct event *p_ev)
+{
+    static const int64_t offsets[8] = {0, 50000, 200000, 210000, 400000, 450000, 520000, 570000};
+    static const int buttons[8] = {LEFT, LEFT, WHEEL_UP, WHEEL_UP, LEFT, LEFT, LEFT, LEFT};
+    p_ev->time = (int64_t) (i / 8) * 1000000 + offsets[i % 8];
+    const bool press = i % 2 == 0;
+    mouse_set(&p_ev->old, 0, press ? 0 : buttons[i % 8], false);
+    mouse_set(&p_ev->new, 0, press ? buttons[i % 8] : 0, false);
+}
+
+// the left button held to play fast, with the right one clicked meanwhile,
+// which ends the fast forward, every second
+static void event_hold_click(uint64_t i, struct event *p_ev)
+{
+    static const int64_t offsets[4] = {0, 600000, 650000, 800000};
+    static const int old_buttons[4] = {0, LEFT, LEFT | RIGHT, LEFT};
+    static const int new_buttons[4] = {LEFT, LEFT | RIGHT, LEFT, 0};
+    p_ev->time = (int64_t) (i / 4) * 1000000 + offsets[i % 4];
+    mouse_set(&p_ev->old, 0, old_buttons[i % 4], false);
+    mouse_set(&p_ev->new, 0, new_buttons[i % 4], false);
+}
+
+static const struct scenario scenarios[] = {
+    {"press", setup_default, event_press, 1000},
+    {"release", setup_default, event_release, 250},
+    {"drag", setup_default, event_drag, 250},
+    {"drag-8khz", setup_default, event_drag_8khz, 250},
+    {"double-click", setup_double_click, event_double_click, 2500},
+    {"remap", setup_remap, event_remap, 1200},
+    {"gestures", setup_gestures, event_gestures, 3000},
+    {"hold-click", setup_hold_click, event_hold_click, 2500},
+};
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// the pictures of a 60 fps video, at most one between two mouse events
+#define PICTURE_PERIOD 16667
+
+// the run is timed in slices, to tell whether the cost per event stays flat
+#define SLICES 10
+
+struct result {
+    // the time the vout thread has spent on every slice of the events, in
+    // nanoseconds
+    int64_t elapsed[SLICES];
+    // the time the interface thread has spent on all of them
+    int64_t intf_elapsed;
+    unsigned toggles;
+    unsigned dropped;
+    // the events after which no button was held but the player was still
+    // left at a fast rate
+    unsigned fast_after_release;
+};
+
+// Runs the interface thread's loop for the wakeups it has got, on this
+// thread. Returns the time it has taken. Only the commands are on the event
+// path, the publishing after them is the thread's housekeeping. With no
+// button held, the player is checked to be back at its normal rate.
+static int64_t intf_step(intf_thread_t *intf, bool released, struct result *p_res)
+{
+    int64_t elapsed = 0;
+    if (vlc_sem_trywait(&intf->p_sys->wakeup) == 0) {
+        const int64_t start = now_ns();
+        do {
+            COUNT_BEGIN();
+            commands_run(intf);
+            COUNT_END();
+            intf_publish(intf);
+        } while (vlc_sem_trywait(&intf->p_sys->wakeup) == 0);
+        elapsed = now_ns() - start;
+    }
+    if (released && vlc_player_GetRate(vlc_playlist_GetPlayer(vlc_intf_GetMainPlaylist(intf))) != 1.f) {
+        p_res->fast_after_release ++;
+    }
+    return elapsed;
+}
+
+// The plugin in a stand-in of VLC 4: the interface, a vout with the filter
+// and the events fed to the filter's mouse callback, with the pictures in
+// between. The interface thread's loop is run right after every event, the
+// timer wheel's thread is waited on whenever the clock passes a deadline.
+// Neither of the two threads is timed along with the vout thread.
+static bool run(const struct scenario *p_sc, uint64_t count, struct result *p_res)
+{
+    shim_module_entry();
+    p_sc->setup();
+    shim_player_reset();
+
+    libvlc_int_t *libvlc = shim_object_new(sizeof(*libvlc), NULL);
+    intf_thread_t *intf = shim_object_new(sizeof(*intf), VLC_OBJECT(libvlc));
+    vout_thread_t *vout = shim_object_new(sizeof(*vout), VLC_OBJECT(libvlc));
+    filter_t *p_filter = shim_object_new(sizeof(*p_filter), VLC_OBJECT(vout));
+    if (!libvlc || !intf || !vout || !p_filter) {
+        fprintf(stderr, "out of memory\n");
+        return false;
+    }
+    var_Create(libvlc, "intf-popupmenu", VLC_VAR_BOOL);
+    var_Create(vout, "fullscreen", VLC_VAR_BOOL);
+    const video_format_t fmt = {
+        .i_chroma = 0x30323449, // I420
+        .i_width = 1920,
+        .i_height = 1080,
+        .i_frame_rate = 60,
+        .i_frame_rate_base = 1,
+    };
+    p_filter->fmt_in.video = fmt;
+    p_filter->fmt_out.video = fmt;
+
+    const vlc_tick_t start = vlc_tick_now();
+    if (OpenInterface(VLC_OBJECT(intf)) != VLC_SUCCESS) {
+        fprintf(stderr, "%s: failed to open the interface\n", p_sc->name);
+        return false;
+    }
+    shim_player_add_vout(vout);
+    if (OpenFilter(VLC_OBJECT(p_filter)) != VLC_SUCCESS) {
+        fprintf(stderr, "%s: failed to open the filter\n", p_sc->name);
+        shim_player_remove_vout(vout);
+        CloseInterface(VLC_OBJECT(intf));
+        return false;
+    }
+    intf_step(intf, false, p_res);
+
+    picture_t picture;
+    int64_t next_picture = 0;
+    unsigned slice = 0;
+    uint64_t slice_end = count / SLICES;
+    int64_t slice_start = now_ns();
+    int64_t waited = shim_clock_waited_ns();
+    int64_t slice_intf = 0;
+    for (uint64_t i = 0; i < count; i ++) {
+        if (i == slice_end && slice < SLICES - 1) {
+            int64_t t = now_ns();
+            int64_t w = shim_clock_waited_ns();
+            p_res->elapsed[slice ++] = t - slice_start - (w - waited) - slice_intf;
+            p_res->intf_elapsed += slice_intf;
+            slice_start = t;
+            waited = w;
+            slice_intf = 0;
+            slice_end = count * (slice + 1) / SLICES;
+        }
+
+        struct event ev;
+        p_sc->event(i, &ev);
+        // fires the timers due by then
+        shim_clock_set(start + VLC_TICK_FROM_US(ev.time));
+        slice_intf += intf_step(intf, false, p_res);
+
+        if (ev.time >= next_picture) {
+            picture.date = start + VLC_TICK_FROM_US(ev.time);
+            COUNT_BEGIN();
+            p_filter->ops->filter_video(p_filter, &picture);
+            COUNT_END();
+            next_picture = ev.time + PICTURE_PERIOD;
+        }
+
+        vlc_mouse_t out = ev.new;
+        COUNT_BEGIN();
+        p_filter->ops->video_mouse(p_filter, &out, &ev.old);
+        COUNT_END();
+        slice_intf += intf_step(intf, !ev.new.i_pressed, p_res);
+    }
+    p_res->elapsed[slice] = now_ns() - slice_start - (shim_clock_waited_ns() - waited) - slice_intf;
+    p_res->intf_elapsed += slice_intf;
+
+    p_res->toggles = counter_get(intf->p_sys, COUNTER_TOGGLES);
+    p_res->dropped = counter_get(intf->p_sys, COUNTER_COMMANDS_DROPPED);
+
+    p_filter->ops->close(p_filter);
+    shim_player_remove_vout(vout);
+    CloseInterface(VLC_OBJECT(intf));
+    shim_object_delete(p_filter);
+    shim_object_delete(vout);
+    shim_object_delete(intf);
+    shim_object_delete(libvlc);
+
+    return true;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [-n EVENTS] [SCENARIO...]\n"
+            "Times the plugin's mouse event path in a stand-in of VLC on\n"
+            "synthetic scenarios: press, release, drag, drag-8khz, double-click,\n"
+            "remap, gestures, hold-click (default all). Fails if the event path\n"
+            "takes longer than the scenario's budget, if it allocates, where the\n"
+            "allocations are counted, or if the player isn't back at its normal\n"
+            "rate once the buttons are released.\n"
+            "\n"
+            "  -n EVENTS  number of events per scenario (default 1000000)\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    long long count = 1000000;
+    int first = argc;
+
+    for (int i = 1; i < argc; i ++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            count = strtoll(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-') {
+            first = i;
+            break;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (count < 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // the interface thread's loop is stepped through by run() instead
+    shim_thread_defer(intf_run);
+#ifdef BENCH_COUNT_ALLOCS
+    shim_thread_on_start(count_thread);
+#endif
+
+    int status = EXIT_SUCCESS;
+    const size_t n_scenarios = sizeof(scenarios)/sizeof(scenarios[0]);
+    for (size_t i = 0; i < n_scenarios; i ++) {
+        bool selected = first == argc;
+        for (int j = first; j < argc; j ++) {
+            selected |= strcmp(argv[j], scenarios[i].name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+
+#ifdef BENCH_COUNT_ALLOCS
+        uint64_t allocations_before = atomic_load(&allocations);
+        uint64_t frees_before = atomic_load(&frees);
+#endif
+        struct result res;
+        memset(&res, 0, sizeof(res));
+        if (!run(&scenarios[i], (uint64_t) count, &res)) {
+            status = EXIT_FAILURE;
+            continue;
+        }
+        int64_t elapsed = 0;
+        double slowest = 0;
+        for (unsigned j = 0; j < SLICES; j ++) {
+            elapsed += res.elapsed[j];
+            uint64_t events = (uint64_t) count * (j + 1) / SLICES - (uint64_t) count * j / SLICES;
+            if (events && (double) res.elapsed[j] / events > slowest) {
+                slowest = (double) res.elapsed[j] / events;
+            }
+        }
+
+        printf("%-13s %8.2f ns/event (slowest tenth %.2f, interface %.2f)", scenarios[i].name,
+               (double) elapsed / count, slowest, (double) res.intf_elapsed / count);
+#ifdef BENCH_COUNT_ALLOCS
+        const uint64_t allocated = atomic_load(&allocations) - allocations_before;
+        const uint64_t freed = atomic_load(&frees) - frees_before;
+        printf("  %.4f allocs/event  %.4f frees/event", (double) allocated / count,
+               (double) freed / count);
+#endif
+        printf("  toggles: %u  dropped: %u\n", res.toggles, res.dropped);
+#ifdef BENCH_COUNT_ALLOCS
+        // the event path runs on the vout thread, which must never wait on
+        // the allocator
+        if (allocated || freed) {
+            fflush(stdout);
+            fprintf(stderr, "%s: the event path has allocated %" PRIu64 " and freed %" PRIu64
+                    " times\n", scenarios[i].name, allocated, freed);
+            status = EXIT_FAILURE;
+        }
+#endif
+        if (elapsed > scenarios[i].budget * count) {
+            fflush(stdout);
+            fprintf(stderr, "%s: over the budget of %" PRId64 " ns/event\n", scenarios[i].name,
+                    scenarios[i].budget);
+            status = EXIT_FAILURE;
+        }
+        // playing fast lasts only for as long as a button is held
+        if (res.fast_after_release) {
+            fflush(stdout);
+            fprintf(stderr, "%s: the player has been left playing fast after %u releases\n",
+                    scenarios[i].name, res.fast_after_release);
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
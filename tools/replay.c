@@ -0,0 +1,322 @@
+/*****************************************************************************
+ * replay.c : Replays recorded mouse traces through the click logic outside of VLC
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "click_logic.h"
+#include "gesture.h"
+#include "trace.h"
+
+struct stats {
+    uint64_t events;
+    uint64_t pause_play;
+    uint64_t timer_start;
+    uint64_t timer_cancel;
+    uint64_t timer_fire;
+    uint64_t double_click_out;
+    uint64_t rollback;
+    // the actions of the gesture bindings other than pause/play
+    uint64_t gesture_actions;
+};
+
+#define GESTURE_ACTIONS_MASK (CLICK_ACTION_TOGGLE_FULLSCREEN | CLICK_ACTION_POPUP_MENU | \
+                              CLICK_ACTION_FAST_FORWARD | CLICK_ACTION_NORMAL_RATE | \
+                              CLICK_ACTION_SEEK_FORWARD | CLICK_ACTION_SEEK_BACKWARD | \
+                              CLICK_ACTION_VOLUME_UP | CLICK_ACTION_VOLUME_DOWN)
+
+static void print_actions(unsigned actions)
+{
+    printf("%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s",
+           actions & CLICK_ACTION_PAUSE_PLAY ? " pause_play" : "",
+           actions & CLICK_ACTION_ROLLBACK ? " rollback" : "",
+           actions & CLICK_ACTION_TIMER_CANCEL ? " timer_cancel" : "",
+           actions & CLICK_ACTION_TIMER_START ? " timer_start" : "",
+           actions & CLICK_ACTION_SET_FULLSCREEN ? " set_fullscreen" : "",
+           actions & CLICK_ACTION_SUPPRESS_CONTEXT_MENU ? " suppress_context_menu" : "",
+           actions & CLICK_ACTION_SET_CONTEXT_MENU ? " set_context_menu" : "",
+           actions & CLICK_ACTION_TOGGLE_FULLSCREEN ? " toggle_fullscreen" : "",
+           actions & CLICK_ACTION_POPUP_MENU ? " popup_menu" : "",
+           actions & CLICK_ACTION_FAST_FORWARD ? " fast_forward" : "",
+           actions & CLICK_ACTION_NORMAL_RATE ? " normal_rate" : "",
+           actions & CLICK_ACTION_SEEK_FORWARD ? " seek_forward" : "",
+           actions & CLICK_ACTION_SEEK_BACKWARD ? " seek_backward" : "",
+           actions & CLICK_ACTION_VOLUME_UP ? " volume_up" : "",
+           actions & CLICK_ACTION_VOLUME_DOWN ? " volume_down" : "");
+}
+
+static int64_t trace_now(void *opaque)
+{
+    return *(const int64_t *) opaque;
+}
+
+// Runs the records through the click logic, or the gesture bindings where the
+// trace has them, the same way the plugin does, with the clock and the timer
+// driven by the record timestamps. Returns false if the trace has bindings
+// this build doesn't know.
+static bool replay(const struct trace_record *records, size_t count, bool verbose, struct stats *st)
+{
+    struct click_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mouse_button = CLICK_BUTTON_LEFT;
+    cfg.fs_mouse_button = CLICK_BUTTON_NONE;
+    cfg.context_menu_mouse_button = CLICK_BUTTON_NONE;
+    struct gesture_table gestures;
+    memset(&gestures, 0, sizeof(gestures));
+
+    int64_t now = 0;
+    const struct click_clock clock = {trace_now, &now};
+    struct click_machine machine;
+    click_machine_init(&machine, &clock);
+    struct gesture_machine gesture_machine;
+    gesture_machine_init(&gesture_machine, &clock);
+    bool timer_pending = false;
+
+    memset(st, 0, sizeof(*st));
+
+    for (size_t i = 0; i <= count; i ++) {
+        const struct trace_record *p_rec = i < count ? &records[i] : NULL;
+        // the bindings replace the click logic, as in the plugin
+        const bool use_gestures = !gesture_table_is_empty(&gestures);
+        const int64_t deadline = use_gestures ? gesture_machine.deadline : machine.deadline;
+
+        // the timer fires before the next event it would have preceded, or
+        // at the end of the trace
+        if (timer_pending && (!p_rec || p_rec->time >= deadline)) {
+            now = deadline;
+            unsigned actions = use_gestures ? gesture_machine_timeout(&gesture_machine, &gestures,
+                                                                      cfg.double_click_delay)
+                                            : click_machine_timeout(&machine, &cfg);
+            timer_pending = actions & CLICK_ACTION_TIMER_START;
+            st->timer_fire ++;
+            if (actions & CLICK_ACTION_PAUSE_PLAY) {
+                st->pause_play ++;
+            }
+            if (actions & GESTURE_ACTIONS_MASK) {
+                st->gesture_actions ++;
+            }
+            if (verbose) {
+                printf("%" PRId64 " timer:", now);
+                print_actions(actions);
+                printf("\n");
+            }
+        }
+
+        if (!p_rec) {
+            break;
+        }
+        now = p_rec->time;
+
+        if (p_rec->type == TRACE_RECORD_CONFIG) {
+            trace_record_to_config(p_rec, &cfg, &machine.learned_delay);
+            // a gestures record follows if the bindings are still set
+            memset(&gestures, 0, sizeof(gestures));
+            if (verbose) {
+                printf("%" PRId64 " config: mouse_button=%d fs_mouse_button=%d "
+                       "context_menu_mouse_button=%d double_click_delay=%" PRId64 " "
+                       "learned_double_click_delay=%" PRId64 " flags=0x%x\n",
+                       p_rec->time, cfg.mouse_button, cfg.fs_mouse_button,
+                       cfg.context_menu_mouse_button, cfg.double_click_delay,
+                       machine.learned_delay, (unsigned) p_rec->u.config.flags);
+            }
+            continue;
+        }
+        if (p_rec->type == TRACE_RECORD_GESTURES) {
+            if (!trace_record_to_gestures(p_rec, &gestures)) {
+                return false;
+            }
+            if (verbose) {
+                printf("%" PRId64 " gestures: bound buttons=0x%x\n", p_rec->time,
+                       (unsigned) gestures.bound);
+            }
+            continue;
+        }
+        if (p_rec->type != TRACE_RECORD_MOUSE) {
+            continue;
+        }
+
+        const struct click_mouse old = {p_rec->u.mouse.old_pressed, p_rec->u.mouse.old_double_click};
+        const struct click_mouse new = {p_rec->u.mouse.new_pressed, p_rec->u.mouse.new_double_click};
+        struct click_mouse out;
+        unsigned actions = use_gestures ? gesture_machine_mouse(&gesture_machine, &gestures,
+                                                                cfg.double_click_delay,
+                                                                cfg.double_click_is_click,
+                                                                &old, &new, &out)
+                                        : click_machine_mouse(&machine, &cfg, &old, &new, &out);
+
+        st->events ++;
+        if (actions & CLICK_ACTION_PAUSE_PLAY) {
+            st->pause_play ++;
+        }
+        if (actions & CLICK_ACTION_ROLLBACK) {
+            st->rollback ++;
+        }
+        if (actions & GESTURE_ACTIONS_MASK) {
+            st->gesture_actions ++;
+        }
+        if (actions & CLICK_ACTION_TIMER_CANCEL) {
+            timer_pending = false;
+            st->timer_cancel ++;
+        }
+        if (actions & CLICK_ACTION_TIMER_START) {
+            timer_pending = true;
+            st->timer_start ++;
+        }
+        if (out.double_click) {
+            st->double_click_out ++;
+        }
+
+        if (verbose) {
+            printf("%" PRId64 " mouse: in=%d/%d,%d/%d out=%d/%d:", p_rec->time,
+                   old.pressed, old.double_click, new.pressed, new.double_click,
+                   out.pressed, out.double_click);
+            print_actions(actions);
+            printf("\n");
+        }
+    }
+
+    return true;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static struct trace_record *load(const char *path, size_t *count)
+{
+    FILE *stream = fopen(path, "rb");
+    if (!stream) {
+        perror(path);
+        return NULL;
+    }
+    if (!trace_read_header(stream)) {
+        fprintf(stderr, "%s: not a pause_click trace\n", path);
+        fclose(stream);
+        return NULL;
+    }
+
+    struct trace_record *records = NULL;
+    size_t capacity = 0;
+    *count = 0;
+    for (;;) {
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            struct trace_record *p = realloc(records, capacity * sizeof(*records));
+            if (!p) {
+                fprintf(stderr, "out of memory\n");
+                free(records);
+                fclose(stream);
+                return NULL;
+            }
+            records = p;
+        }
+        if (!trace_read(stream, &records[*count])) {
+            break;
+        }
+        (*count) ++;
+    }
+    fclose(stream);
+
+    return records;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [-v] [-n ITERATIONS] TRACE_FILE\n"
+            "Replays a mouse event trace recorded by the pause_click plugin\n"
+            "through the plugin's click logic, or its gesture bindings if the trace\n"
+            "has them, and reports its decisions and speed.\n"
+            "\n"
+            "  -v             print the decision made on every record\n"
+            "  -n ITERATIONS  number of times to replay the trace when timing (default 1000)\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = false;
+    long iterations = 1000;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i ++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = strtol(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!path || iterations < 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size_t count;
+    struct trace_record *records = load(path, &count);
+    if (!records) {
+        return EXIT_FAILURE;
+    }
+
+    struct stats st;
+    if (!replay(records, count, verbose, &st)) {
+        fprintf(stderr, "%s: the trace has gesture bindings this build doesn't know\n", path);
+        free(records);
+        return EXIT_FAILURE;
+    }
+    printf("events: %" PRIu64 "\n"
+           "pause_play: %" PRIu64 "\n"
+           "timer started: %" PRIu64 ", cancelled: %" PRIu64 ", fired: %" PRIu64 "\n"
+           "double clicks passed to VLC: %" PRIu64 "\n"
+           "rollbacks: %" PRIu64 "\n"
+           "other gesture actions: %" PRIu64 "\n",
+           st.events, st.pause_play, st.timer_start, st.timer_cancel, st.timer_fire,
+           st.double_click_out, st.rollback, st.gesture_actions);
+
+    int64_t start = now_ns();
+    for (long i = 0; i < iterations; i ++) {
+        replay(records, count, false, &st);
+    }
+    int64_t elapsed = now_ns() - start;
+    double events = (double) st.events * iterations;
+    if (elapsed > 0 && events > 0) {
+        printf("%.0f events/sec, %.1f ns/event\n", events * 1e9 / elapsed, elapsed / events);
+    }
+
+    free(records);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * shim.h : Driving the libvlccore stand-in
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+// What the bench does to the stand-in in place of VLC: creating the objects,
+// moving the clock forward, starting and stopping vouts on the player.
+
+#ifndef SHIM_H
+#define SHIM_H
+
+#include "vlc_common.h"
+
+// (re)registers the plugin's settings with their defaults, defined by the
+// vlc_module_begin() of the plugin
+int shim_module_entry(void);
+
+// a zeroed object of the given size, a child of the parent
+void *shim_object_new(size_t size, vlc_object_t *parent);
+void shim_object_delete(void *obj);
+
+// Sets the time vlc_tick_now() returns, which only moves when this is called.
+// Wakes up the threads whose vlc_cond_timedwait() is due then and waits for
+// all the threads started with vlc_clone() to block again, so that the
+// timers due by then have fired once it returns.
+void shim_clock_set(vlc_tick_t now);
+// the wall clock time shim_clock_set() has spent waiting for the threads, in
+// nanoseconds
+int64_t shim_clock_waited_ns(void);
+
+// vlc_clone() of this entry doesn't start a thread, vlc_join() runs it
+// instead, on the calling thread
+void shim_thread_defer(void *(*entry)(void *));
+// called at the start of every thread vlc_clone() starts
+void shim_thread_on_start(void (*callback)(void));
+
+// a player that is playing and the vout changes the listeners are told about
+void shim_player_reset(void);
+void shim_player_add_vout(vout_thread_t *vout);
+void shim_player_remove_vout(vout_thread_t *vout);
+// the calls that would have changed the player's state, rate, time or volume
+unsigned shim_player_controls(void);
+
+#endif
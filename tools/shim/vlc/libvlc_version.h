@@ -0,0 +1,34 @@
+/*****************************************************************************
+ * libvlc_version.h : Version of the libvlccore stand-in
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SHIM_LIBVLC_VERSION_H
+#define SHIM_LIBVLC_VERSION_H
+
+// the shim follows the VLC 4.0 API
+#define LIBVLC_VERSION_MAJOR 4
+#define LIBVLC_VERSION_MINOR 0
+#define LIBVLC_VERSION_REVISION 0
+#define LIBVLC_VERSION_EXTRA 0
+
+#endif
@@ -0,0 +1,551 @@
+/*****************************************************************************
+ * vlc_common.h : Stand-in for the parts of libvlccore the plugin uses
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+// Mimics the VLC 4.0 API closely enough for src/pause_click.c and
+// src/timer_wheel.c to build and run outside of VLC, see tools/shim/shim.h.
+// All the VLC headers the plugin includes end up here, the Makefile
+// generating the ones other than vlc_atomic.h and vlc/libvlc_version.h to
+// forward to this one.
+
+#ifndef SHIM_VLC_COMMON_H
+#define SHIM_VLC_COMMON_H
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc/libvlc_version.h>
+#include <vlc_atomic.h>
+
+#define VLC_SUCCESS 0
+#define VLC_EGENERIC (-1)
+#define VLC_ENOMEM (-2)
+
+// ticks
+
+typedef int64_t vlc_tick_t;
+
+#define CLOCK_FREQ INT64_C(1000000)
+#define VLC_TICK_INVALID 0
+#define VLC_TICK_FROM_US(us) ((vlc_tick_t) (us))
+#define US_FROM_VLC_TICK(t) ((int64_t) (t))
+
+// the clock of the shim, which the bench moves forward, see shim_clock_set()
+vlc_tick_t vlc_tick_now(void);
+
+// objects
+
+typedef struct vlc_object_t {
+    struct vlc_object_t *parent;
+    struct shim_var *vars;
+} vlc_object_t;
+
+#define VLC_OBJECT(x) ((vlc_object_t *) (x))
+
+typedef struct libvlc_int_t {
+    vlc_object_t obj;
+} libvlc_int_t;
+
+vlc_object_t *shim_object_parent(vlc_object_t *obj);
+libvlc_int_t *shim_object_instance(vlc_object_t *obj);
+#define vlc_object_parent(o) shim_object_parent(VLC_OBJECT(o))
+#define vlc_object_instance(o) shim_object_instance(VLC_OBJECT(o))
+
+typedef struct intf_sys_t intf_sys_t;
+
+typedef struct intf_thread_t {
+    vlc_object_t obj;
+    intf_sys_t *p_sys;
+} intf_thread_t;
+
+typedef struct vout_thread_t {
+    vlc_object_t obj;
+} vout_thread_t;
+
+// the vouts of the shim aren't reference counted
+static inline vout_thread_t *vout_Hold(vout_thread_t *vout)
+{
+    return vout;
+}
+
+static inline void vout_Release(vout_thread_t *vout)
+{
+    (void) vout;
+}
+
+// variables
+
+typedef union {
+    int64_t i_int;
+    bool b_bool;
+    float f_float;
+    char *psz_string;
+    void *p_address;
+} vlc_value_t;
+
+typedef int (*vlc_callback_t)(vlc_object_t *, const char *, vlc_value_t, vlc_value_t, void *);
+
+#define VLC_VAR_BOOL 0x0020
+#define VLC_VAR_INTEGER 0x0030
+#define VLC_VAR_STRING 0x0040
+#define VLC_VAR_FLOAT 0x0050
+#define VLC_VAR_ADDRESS 0x0070
+#define VLC_VAR_CLASS 0x00f0
+#define VLC_VAR_DOINHERIT 0x8000
+
+int shim_var_Create(vlc_object_t *obj, const char *name, int type);
+void shim_var_Destroy(vlc_object_t *obj, const char *name);
+void shim_var_AddCallback(vlc_object_t *obj, const char *name, vlc_callback_t cb, void *data);
+void shim_var_DelCallback(vlc_object_t *obj, const char *name, vlc_callback_t cb, void *data);
+int shim_var_Get(vlc_object_t *obj, const char *name, int type, vlc_value_t *val);
+int shim_var_Set(vlc_object_t *obj, const char *name, int type, vlc_value_t val);
+int shim_var_Inherit(vlc_object_t *obj, const char *name, int type, vlc_value_t *val);
+// the type of the variable, 0 if there is none
+int shim_var_Type(vlc_object_t *obj, const char *name);
+
+#define var_Create(o, n, t) shim_var_Create(VLC_OBJECT(o), n, t)
+#define var_Destroy(o, n) shim_var_Destroy(VLC_OBJECT(o), n)
+#define var_AddCallback(o, n, cb, d) shim_var_AddCallback(VLC_OBJECT(o), n, cb, d)
+#define var_DelCallback(o, n, cb, d) shim_var_DelCallback(VLC_OBJECT(o), n, cb, d)
+#define var_Type(o, n) shim_var_Type(VLC_OBJECT(o), n)
+
+static inline int64_t shim_var_GetInteger(vlc_object_t *obj, const char *name)
+{
+    vlc_value_t val;
+    return shim_var_Get(obj, name, VLC_VAR_INTEGER, &val) ? 0 : val.i_int;
+}
+
+static inline bool shim_var_GetBool(vlc_object_t *obj, const char *name)
+{
+    vlc_value_t val;
+    return shim_var_Get(obj, name, VLC_VAR_BOOL, &val) ? false : val.b_bool;
+}
+
+static inline char *shim_var_GetString(vlc_object_t *obj, const char *name)
+{
+    vlc_value_t val;
+    return shim_var_Get(obj, name, VLC_VAR_STRING, &val) ? NULL : val.psz_string;
+}
+
+static inline void *shim_var_GetAddress(vlc_object_t *obj, const char *name)
+{
+    vlc_value_t val;
+    return shim_var_Get(obj, name, VLC_VAR_ADDRESS, &val) ? NULL : val.p_address;
+}
+
+static inline int shim_var_SetInteger(vlc_object_t *obj, const char *name, int64_t i)
+{
+    vlc_value_t val;
+    val.i_int = i;
+    return shim_var_Set(obj, name, VLC_VAR_INTEGER, val);
+}
+
+static inline int shim_var_SetBool(vlc_object_t *obj, const char *name, bool b)
+{
+    vlc_value_t val;
+    val.b_bool = b;
+    return shim_var_Set(obj, name, VLC_VAR_BOOL, val);
+}
+
+static inline int shim_var_SetString(vlc_object_t *obj, const char *name, const char *psz)
+{
+    vlc_value_t val;
+    val.psz_string = (char *) psz;
+    return shim_var_Set(obj, name, VLC_VAR_STRING, val);
+}
+
+static inline int shim_var_SetAddress(vlc_object_t *obj, const char *name, void *p)
+{
+    vlc_value_t val;
+    val.p_address = p;
+    return shim_var_Set(obj, name, VLC_VAR_ADDRESS, val);
+}
+
+static inline int shim_var_ToggleBool(vlc_object_t *obj, const char *name)
+{
+    vlc_value_t val;
+    if (shim_var_Get(obj, name, VLC_VAR_BOOL, &val)) {
+        return VLC_EGENERIC;
+    }
+    val.b_bool = !val.b_bool;
+    return shim_var_Set(obj, name, VLC_VAR_BOOL, val);
+}
+
+static inline int64_t shim_var_InheritInteger(vlc_object_t *obj, const char *name)
+{
+    vlc_value_t val;
+    return shim_var_Inherit(obj, name, VLC_VAR_INTEGER, &val) ? 0 : val.i_int;
+}
+
+static inline bool shim_var_InheritBool(vlc_object_t *obj, const char *name)
+{
+    vlc_value_t val;
+    return shim_var_Inherit(obj, name, VLC_VAR_BOOL, &val) ? false : val.b_bool;
+}
+
+// NULL for an empty string, like VLC's
+static inline char *shim_var_InheritString(vlc_object_t *obj, const char *name)
+{
+    vlc_value_t val;
+    if (shim_var_Inherit(obj, name, VLC_VAR_STRING, &val)) {
+        return NULL;
+    }
+    if (val.psz_string && !*val.psz_string) {
+        free(val.psz_string);
+        return NULL;
+    }
+    return val.psz_string;
+}
+
+#define var_GetInteger(o, n) shim_var_GetInteger(VLC_OBJECT(o), n)
+#define var_GetBool(o, n) shim_var_GetBool(VLC_OBJECT(o), n)
+#define var_GetString(o, n) shim_var_GetString(VLC_OBJECT(o), n)
+#define var_GetAddress(o, n) shim_var_GetAddress(VLC_OBJECT(o), n)
+#define var_Set(o, n, v) shim_var_Set(VLC_OBJECT(o), n, 0, v)
+#define var_SetInteger(o, n, v) shim_var_SetInteger(VLC_OBJECT(o), n, v)
+#define var_SetBool(o, n, v) shim_var_SetBool(VLC_OBJECT(o), n, v)
+#define var_SetString(o, n, v) shim_var_SetString(VLC_OBJECT(o), n, v)
+#define var_SetAddress(o, n, v) shim_var_SetAddress(VLC_OBJECT(o), n, v)
+#define var_ToggleBool(o, n) shim_var_ToggleBool(VLC_OBJECT(o), n)
+#define var_InheritInteger(o, n) shim_var_InheritInteger(VLC_OBJECT(o), n)
+#define var_InheritBool(o, n) shim_var_InheritBool(VLC_OBJECT(o), n)
+#define var_InheritString(o, n) shim_var_InheritString(VLC_OBJECT(o), n)
+
+// the config, which the inherited variables fall back on
+
+int64_t config_GetInt(const char *name);
+void config_PutInt(const char *name, int64_t value);
+char *config_GetPsz(const char *name);
+void config_PutPsz(const char *name, const char *value);
+
+// messages, formatted and dropped
+
+enum vlc_log_type {
+    VLC_MSG_INFO,
+    VLC_MSG_ERR,
+    VLC_MSG_WARN,
+    VLC_MSG_DBG,
+};
+
+void shim_msg(vlc_object_t *obj, int type, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define msg_Err(o, ...) shim_msg(VLC_OBJECT(o), VLC_MSG_ERR, __VA_ARGS__)
+#define msg_Warn(o, ...) shim_msg(VLC_OBJECT(o), VLC_MSG_WARN, __VA_ARGS__)
+#define msg_Dbg(o, ...) shim_msg(VLC_OBJECT(o), VLC_MSG_DBG, __VA_ARGS__)
+
+// threads
+
+typedef pthread_mutex_t vlc_mutex_t;
+typedef pthread_cond_t vlc_cond_t;
+typedef sem_t vlc_sem_t;
+typedef struct shim_thread *vlc_thread_t;
+
+#define VLC_STATIC_MUTEX PTHREAD_MUTEX_INITIALIZER
+
+static inline void vlc_mutex_init(vlc_mutex_t *mutex)
+{
+    pthread_mutex_init(mutex, NULL);
+}
+
+static inline void vlc_mutex_lock(vlc_mutex_t *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+static inline void vlc_mutex_unlock(vlc_mutex_t *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+static inline void vlc_cond_init(vlc_cond_t *cond)
+{
+    pthread_cond_init(cond, NULL);
+}
+
+static inline void vlc_cond_signal(vlc_cond_t *cond)
+{
+    pthread_cond_signal(cond);
+}
+
+static inline void vlc_cond_broadcast(vlc_cond_t *cond)
+{
+    pthread_cond_broadcast(cond);
+}
+
+void vlc_cond_wait(vlc_cond_t *cond, vlc_mutex_t *mutex);
+// the deadline is on the shim's clock
+int vlc_cond_timedwait(vlc_cond_t *cond, vlc_mutex_t *mutex, vlc_tick_t deadline);
+
+static inline void vlc_sem_init(vlc_sem_t *sem, unsigned value)
+{
+    sem_init(sem, 0, value);
+}
+
+static inline void vlc_sem_post(vlc_sem_t *sem)
+{
+    sem_post(sem);
+}
+
+void vlc_sem_wait(vlc_sem_t *sem);
+
+static inline int vlc_sem_trywait(vlc_sem_t *sem)
+{
+    return sem_trywait(sem) ? EAGAIN : 0;
+}
+
+int vlc_clone(vlc_thread_t *th, void *(*entry)(void *), void *data);
+void vlc_join(vlc_thread_t th, void **result);
+
+// files
+
+static inline FILE *vlc_fopen(const char *filename, const char *mode)
+{
+    return fopen(filename, mode);
+}
+
+// video
+
+typedef uint32_t vlc_fourcc_t;
+
+typedef struct {
+    vlc_fourcc_t i_chroma;
+    unsigned i_width;
+    unsigned i_height;
+    unsigned i_frame_rate;
+    unsigned i_frame_rate_base;
+} video_format_t;
+
+typedef struct {
+    video_format_t video;
+} es_format_t;
+
+typedef struct {
+    unsigned plane_count;
+} vlc_chroma_description_t;
+
+// every chroma is an opaque one to the shim
+static inline const vlc_chroma_description_t *vlc_fourcc_GetChromaDescription(vlc_fourcc_t fourcc)
+{
+    (void) fourcc;
+    return NULL;
+}
+
+static inline void shim_video_format_Print(vlc_object_t *obj, const char *prefix,
+                                           const video_format_t *fmt)
+{
+    (void) obj;
+    (void) prefix;
+    (void) fmt;
+}
+
+#define video_format_Print(o, p, f) shim_video_format_Print(VLC_OBJECT(o), p, f)
+
+typedef struct picture_t {
+    vlc_tick_t date;
+} picture_t;
+
+// the mouse
+
+enum vlc_mouse_button {
+    MOUSE_BUTTON_LEFT,
+    MOUSE_BUTTON_CENTER,
+    MOUSE_BUTTON_RIGHT,
+    MOUSE_BUTTON_WHEEL_UP,
+    MOUSE_BUTTON_WHEEL_DOWN,
+    MOUSE_BUTTON_WHEEL_LEFT,
+    MOUSE_BUTTON_WHEEL_RIGHT,
+};
+
+typedef struct vlc_mouse_t {
+    int i_x;
+    int i_y;
+    int i_pressed;
+    bool b_double_click;
+} vlc_mouse_t;
+
+static inline void vlc_mouse_Init(vlc_mouse_t *p_mouse)
+{
+    memset(p_mouse, 0, sizeof(*p_mouse));
+}
+
+// the OSD, which shows nothing
+
+#define VOUT_SPU_CHANNEL_OSD 1
+
+enum {
+    OSD_PLAY_ICON = 1,
+    OSD_PAUSE_ICON,
+};
+
+static inline void vout_OSDIcon(vout_thread_t *vout, int channel, short type)
+{
+    (void) vout;
+    (void) channel;
+    (void) type;
+}
+
+// filters
+
+typedef struct filter_t filter_t;
+
+struct vlc_filter_operations {
+    picture_t *(*filter_video)(filter_t *, picture_t *);
+    int (*video_mouse)(filter_t *, vlc_mouse_t *, const vlc_mouse_t *);
+    void (*close)(filter_t *);
+};
+
+struct filter_t {
+    vlc_object_t obj;
+    void *p_sys;
+    es_format_t fmt_in;
+    es_format_t fmt_out;
+    bool b_allow_fmt_out_change;
+    const struct vlc_filter_operations *ops;
+};
+
+typedef int (*vlc_filter_open)(filter_t *);
+
+// the player, see shim_player_*() for driving it
+
+typedef struct vlc_player_t vlc_player_t;
+typedef struct vlc_playlist vlc_playlist_t;
+typedef struct vlc_player_listener_id vlc_player_listener_id;
+typedef struct vlc_es_id_t vlc_es_id_t;
+typedef struct input_item_t input_item_t;
+
+enum vlc_player_state {
+    VLC_PLAYER_STATE_STOPPED,
+    VLC_PLAYER_STATE_STARTED,
+    VLC_PLAYER_STATE_PLAYING,
+    VLC_PLAYER_STATE_PAUSED,
+    VLC_PLAYER_STATE_STOPPING,
+};
+
+enum vlc_player_seek_speed {
+    VLC_PLAYER_SEEK_PRECISE,
+    VLC_PLAYER_SEEK_FAST,
+};
+
+enum vlc_player_whence {
+    VLC_PLAYER_WHENCE_ABSOLUTE,
+    VLC_PLAYER_WHENCE_RELATIVE,
+};
+
+enum vlc_player_vout_action {
+    VLC_PLAYER_VOUT_STARTED,
+    VLC_PLAYER_VOUT_STOPPED,
+};
+
+enum vlc_vout_order {
+    VLC_VOUT_ORDER_NONE,
+    VLC_VOUT_ORDER_PRIMARY,
+    VLC_VOUT_ORDER_SECONDARY,
+};
+
+#define VLC_PLAYER_TITLE_MENU 0x01
+#define VLC_PLAYER_TITLE_INTERACTIVE 0x02
+
+struct vlc_player_title {
+    const char *name;
+    vlc_tick_t length;
+    unsigned flags;
+};
+
+struct vlc_player_cbs {
+    void (*on_current_media_changed)(vlc_player_t *player, input_item_t *new_media, void *data);
+    void (*on_state_changed)(vlc_player_t *player, enum vlc_player_state new_state, void *data);
+    void (*on_vout_changed)(vlc_player_t *player, enum vlc_player_vout_action action,
+                            vout_thread_t *vout, enum vlc_vout_order order,
+                            vlc_es_id_t *es_id, void *data);
+};
+
+vlc_playlist_t *vlc_intf_GetMainPlaylist(intf_thread_t *intf);
+vlc_player_t *vlc_playlist_GetPlayer(vlc_playlist_t *playlist);
+void vlc_player_Lock(vlc_player_t *player);
+void vlc_player_Unlock(vlc_player_t *player);
+vlc_player_listener_id *vlc_player_AddListener(vlc_player_t *player,
+                                               const struct vlc_player_cbs *cbs, void *data);
+void vlc_player_RemoveListener(vlc_player_t *player, vlc_player_listener_id *id);
+enum vlc_player_state vlc_player_GetState(vlc_player_t *player);
+const struct vlc_player_title *vlc_player_GetSelectedTitle(vlc_player_t *player);
+vlc_tick_t vlc_player_GetTime(vlc_player_t *player);
+float vlc_player_GetRate(vlc_player_t *player);
+void vlc_player_ChangeRate(vlc_player_t *player, float rate);
+void vlc_player_Pause(vlc_player_t *player);
+void vlc_player_Resume(vlc_player_t *player);
+void vlc_player_SeekByTime(vlc_player_t *player, vlc_tick_t time,
+                           enum vlc_player_seek_speed speed, enum vlc_player_whence whence);
+int vlc_player_aout_IncrementVolume(vlc_player_t *player, int steps, float *result);
+vout_thread_t **vlc_player_vout_HoldAll(vlc_player_t *player, size_t *count);
+
+// the plugin descriptor, which only registers the settings with their
+// defaults, see shim_module_entry()
+
+#define SUBCAT_VIDEO_VFILTER 0
+#define SUBCAT_INTERFACE_CONTROL 0
+#define VLC_CONFIG_LIST 0
+
+int shim_module_entry(void);
+void shim_config_add(const char *name, int type, int64_t value, const char *psz_value);
+
+static inline void shim_config_set(int property, ...)
+{
+    (void) property;
+}
+
+#define vlc_module_begin() \
+    int shim_module_entry(void) {
+#define vlc_module_end() \
+        return VLC_SUCCESS; \
+    }
+#define add_submodule()
+#define set_description(desc) (void) (desc);
+#define set_shortname(name) (void) (name);
+#define set_help_html(help) (void) (help);
+#define set_capability(cap, score) (void) (cap); (void) (score);
+#define set_callback_video_filter(open) (void) (open);
+#define set_callbacks(open, close) (void) (open); (void) (close);
+#define set_subcategory(subcat) (void) (subcat);
+#define set_section(text, longtext) (void) (text); (void) (longtext);
+#define add_bool(name, v, text, longtext) \
+    shim_config_add(name, VLC_VAR_BOOL, v, NULL); (void) (text); (void) (longtext);
+#define add_integer(name, value, text, longtext) \
+    shim_config_add(name, VLC_VAR_INTEGER, value, NULL); (void) (text); (void) (longtext);
+#define add_integer_with_range(name, value, i_min, i_max, text, longtext) \
+    add_integer(name, value, text, longtext) (void) (i_min); (void) (i_max);
+#define add_string(name, value, text, longtext) \
+    shim_config_add(name, VLC_VAR_STRING, 0, value); (void) (text); (void) (longtext);
+#define change_integer_list(list, list_text) (void) (list); (void) (list_text);
+#define change_private()
+#define vlc_config_set(...) shim_config_set(__VA_ARGS__)
+
+#endif
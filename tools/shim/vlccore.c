@@ -0,0 +1,832 @@
+/*****************************************************************************
+ * vlccore.c : The libvlccore stand-in
+ *****************************************************************************
+ * Copyright (C) 2014-2025 Maxim Biro
+ *
+ * Authors: Maxim Biro <nurupo.contributions@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "shim.h"
+
+#include <time.h>
+
+// the clock and the threads
+
+struct shim_thread {
+    pthread_t handle;
+    void *(*entry)(void *);
+    void *data;
+    bool deferred;
+    void *result;
+};
+
+// a thread blocked in vlc_cond_(timed)wait()
+struct waiter {
+    struct waiter *p_next;
+    vlc_cond_t *cond;
+    vlc_mutex_t *mutex;
+    // INT64_MAX if there is none
+    vlc_tick_t deadline;
+    bool kicked;
+};
+
+// protects the rest of the clock and the threads
+static pthread_mutex_t clock_lock = PTHREAD_MUTEX_INITIALIZER;
+// signaled when no thread is running anymore
+static pthread_cond_t clock_settled = PTHREAD_COND_INITIALIZER;
+static _Atomic vlc_tick_t clock_now = CLOCK_FREQ;
+static struct waiter *waiters = NULL;
+// the threads started with vlc_clone() that aren't blocked in a wait
+static unsigned running = 0;
+static int64_t clock_waited = 0;
+
+static void *(*deferred_entry)(void *) = NULL;
+static void (*thread_start_callback)(void) = NULL;
+// whether the calling thread has been started with vlc_clone()
+static _Thread_local bool thread_tracked = false;
+
+vlc_tick_t vlc_tick_now(void)
+{
+    return atomic_load_explicit(&clock_now, memory_order_acquire);
+}
+
+static int64_t wall_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// must be called with clock_lock locked
+static struct waiter *waiter_due(void)
+{
+    const vlc_tick_t now = atomic_load(&clock_now);
+    for (struct waiter *w = waiters; w; w = w->p_next) {
+        if (w->deadline <= now && !w->kicked) {
+            return w;
+        }
+    }
+    return NULL;
+}
+
+// must be called with clock_lock locked
+static bool settled(void)
+{
+    if (running > 0) {
+        return false;
+    }
+    const vlc_tick_t now = atomic_load(&clock_now);
+    for (struct waiter *w = waiters; w; w = w->p_next) {
+        if (w->deadline <= now) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void shim_clock_set(vlc_tick_t now)
+{
+    pthread_mutex_lock(&clock_lock);
+    atomic_store_explicit(&clock_now, now, memory_order_release);
+    if (settled()) {
+        pthread_mutex_unlock(&clock_lock);
+        return;
+    }
+    const int64_t start = wall_ns();
+    for (;;) {
+        struct waiter *w = waiter_due();
+        if (w) {
+            // the waiter holds its mutex until it blocks, so once we have it
+            // the broadcast can't be missed
+            w->kicked = true;
+            vlc_cond_t *cond = w->cond;
+            vlc_mutex_t *mutex = w->mutex;
+            pthread_mutex_unlock(&clock_lock);
+            pthread_mutex_lock(mutex);
+            pthread_cond_broadcast(cond);
+            pthread_mutex_unlock(mutex);
+            pthread_mutex_lock(&clock_lock);
+            continue;
+        }
+        if (settled()) {
+            break;
+        }
+        pthread_cond_wait(&clock_settled, &clock_lock);
+    }
+    clock_waited += wall_ns() - start;
+    pthread_mutex_unlock(&clock_lock);
+}
+
+int64_t shim_clock_waited_ns(void)
+{
+    pthread_mutex_lock(&clock_lock);
+    const int64_t waited = clock_waited;
+    pthread_mutex_unlock(&clock_lock);
+    return waited;
+}
+
+// must be called with clock_lock locked
+static void thread_block(void)
+{
+    if (thread_tracked && --running == 0) {
+        pthread_cond_broadcast(&clock_settled);
+    }
+}
+
+// must be called with clock_lock locked
+static void thread_unblock(void)
+{
+    if (thread_tracked) {
+        running ++;
+    }
+}
+
+static int cond_wait(vlc_cond_t *cond, vlc_mutex_t *mutex, vlc_tick_t deadline)
+{
+    struct waiter w = {NULL, cond, mutex, deadline, false};
+
+    pthread_mutex_lock(&clock_lock);
+    if (deadline <= atomic_load(&clock_now)) {
+        pthread_mutex_unlock(&clock_lock);
+        return ETIMEDOUT;
+    }
+    w.p_next = waiters;
+    waiters = &w;
+    thread_block();
+    pthread_mutex_unlock(&clock_lock);
+
+    pthread_cond_wait(cond, mutex);
+
+    pthread_mutex_lock(&clock_lock);
+    struct waiter **pp = &waiters;
+    while (*pp != &w) {
+        pp = &(*pp)->p_next;
+    }
+    *pp = w.p_next;
+    thread_unblock();
+    const bool timed_out = deadline <= atomic_load(&clock_now);
+    pthread_mutex_unlock(&clock_lock);
+
+    return timed_out ? ETIMEDOUT : 0;
+}
+
+void vlc_cond_wait(vlc_cond_t *cond, vlc_mutex_t *mutex)
+{
+    cond_wait(cond, mutex, INT64_MAX);
+}
+
+int vlc_cond_timedwait(vlc_cond_t *cond, vlc_mutex_t *mutex, vlc_tick_t deadline)
+{
+    return cond_wait(cond, mutex, deadline);
+}
+
+void vlc_sem_wait(vlc_sem_t *sem)
+{
+    if (sem_trywait(sem) == 0) {
+        return;
+    }
+    pthread_mutex_lock(&clock_lock);
+    thread_block();
+    pthread_mutex_unlock(&clock_lock);
+
+    while (sem_wait(sem) && errno == EINTR) {
+    }
+
+    pthread_mutex_lock(&clock_lock);
+    thread_unblock();
+    pthread_mutex_unlock(&clock_lock);
+}
+
+void shim_thread_defer(void *(*entry)(void *))
+{
+    deferred_entry = entry;
+}
+
+void shim_thread_on_start(void (*callback)(void))
+{
+    thread_start_callback = callback;
+}
+
+static void *thread_run(void *data)
+{
+    struct shim_thread *th = (struct shim_thread *) data;
+
+    thread_tracked = true;
+    if (thread_start_callback) {
+        thread_start_callback();
+    }
+    void *result = th->entry(th->data);
+
+    pthread_mutex_lock(&clock_lock);
+    thread_block();
+    pthread_mutex_unlock(&clock_lock);
+
+    return result;
+}
+
+int vlc_clone(vlc_thread_t *p_th, void *(*entry)(void *), void *data)
+{
+    struct shim_thread *th = malloc(sizeof(*th));
+    if (!th) {
+        return VLC_ENOMEM;
+    }
+    th->entry = entry;
+    th->data = data;
+    th->deferred = entry == deferred_entry;
+    th->result = NULL;
+    if (!th->deferred) {
+        // counted as running right away, so that shim_clock_set() waits for
+        // the thread to get going
+        pthread_mutex_lock(&clock_lock);
+        running ++;
+        pthread_mutex_unlock(&clock_lock);
+        if (pthread_create(&th->handle, NULL, thread_run, th)) {
+            pthread_mutex_lock(&clock_lock);
+            running --;
+            pthread_mutex_unlock(&clock_lock);
+            free(th);
+            return VLC_EGENERIC;
+        }
+    }
+    *p_th = th;
+
+    return VLC_SUCCESS;
+}
+
+void vlc_join(vlc_thread_t th, void **result)
+{
+    if (th->deferred) {
+        th->result = th->entry(th->data);
+    } else {
+        pthread_join(th->handle, &th->result);
+    }
+    if (result) {
+        *result = th->result;
+    }
+    free(th);
+}
+
+// objects and variables
+
+#define CALLBACKS_MAX 16
+
+struct shim_var {
+    struct shim_var *p_next;
+    char name[64];
+    int type;
+    unsigned refs;
+    vlc_value_t val;
+    struct {
+        vlc_callback_t cb;
+        void *data;
+    } callbacks[CALLBACKS_MAX];
+    unsigned callback_count;
+};
+
+// protects the variables of all the objects
+static pthread_mutex_t vars_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void *shim_object_new(size_t size, vlc_object_t *parent)
+{
+    vlc_object_t *obj = calloc(1, size);
+    if (obj) {
+        obj->parent = parent;
+    }
+    return obj;
+}
+
+void shim_object_delete(void *p_obj)
+{
+    vlc_object_t *obj = (vlc_object_t *) p_obj;
+    while (obj->vars) {
+        struct shim_var *var = obj->vars;
+        obj->vars = var->p_next;
+        if ((var->type & VLC_VAR_CLASS) == VLC_VAR_STRING) {
+            free(var->val.psz_string);
+        }
+        free(var);
+    }
+    free(obj);
+}
+
+vlc_object_t *shim_object_parent(vlc_object_t *obj)
+{
+    return obj->parent;
+}
+
+libvlc_int_t *shim_object_instance(vlc_object_t *obj)
+{
+    while (obj->parent) {
+        obj = obj->parent;
+    }
+    return (libvlc_int_t *) obj;
+}
+
+// must be called with vars_lock locked
+static struct shim_var *var_find(vlc_object_t *obj, const char *name)
+{
+    for (struct shim_var *var = obj->vars; var; var = var->p_next) {
+        if (strcmp(var->name, name) == 0) {
+            return var;
+        }
+    }
+    return NULL;
+}
+
+// must be called with vars_lock locked, duplicates the strings
+static void value_copy(int type, vlc_value_t *dst, vlc_value_t src)
+{
+    *dst = src;
+    if ((type & VLC_VAR_CLASS) == VLC_VAR_STRING) {
+        dst->psz_string = strdup(src.psz_string ? src.psz_string : "");
+    }
+}
+
+int shim_var_Create(vlc_object_t *obj, const char *name, int type)
+{
+    pthread_mutex_lock(&vars_lock);
+    struct shim_var *var = var_find(obj, name);
+    if (var) {
+        var->refs ++;
+        pthread_mutex_unlock(&vars_lock);
+        return VLC_SUCCESS;
+    }
+    pthread_mutex_unlock(&vars_lock);
+
+    var = calloc(1, sizeof(*var));
+    if (!var) {
+        return VLC_ENOMEM;
+    }
+    snprintf(var->name, sizeof(var->name), "%s", name);
+    var->type = type & VLC_VAR_CLASS;
+    var->refs = 1;
+    if (!(type & VLC_VAR_DOINHERIT) || shim_var_Inherit(obj, name, var->type, &var->val)) {
+        memset(&var->val, 0, sizeof(var->val));
+    }
+
+    pthread_mutex_lock(&vars_lock);
+    var->p_next = obj->vars;
+    obj->vars = var;
+    pthread_mutex_unlock(&vars_lock);
+
+    return VLC_SUCCESS;
+}
+
+void shim_var_Destroy(vlc_object_t *obj, const char *name)
+{
+    pthread_mutex_lock(&vars_lock);
+    struct shim_var **pp = &obj->vars;
+    while (*pp && strcmp((*pp)->name, name) != 0) {
+        pp = &(*pp)->p_next;
+    }
+    struct shim_var *var = *pp;
+    if (var && --var->refs == 0) {
+        *pp = var->p_next;
+    } else {
+        var = NULL;
+    }
+    pthread_mutex_unlock(&vars_lock);
+
+    if (var) {
+        if (var->type == VLC_VAR_STRING) {
+            free(var->val.psz_string);
+        }
+        free(var);
+    }
+}
+
+void shim_var_AddCallback(vlc_object_t *obj, const char *name, vlc_callback_t cb, void *data)
+{
+    pthread_mutex_lock(&vars_lock);
+    struct shim_var *var = var_find(obj, name);
+    if (var && var->callback_count < CALLBACKS_MAX) {
+        var->callbacks[var->callback_count].cb = cb;
+        var->callbacks[var->callback_count].data = data;
+        var->callback_count ++;
+    }
+    pthread_mutex_unlock(&vars_lock);
+}
+
+void shim_var_DelCallback(vlc_object_t *obj, const char *name, vlc_callback_t cb, void *data)
+{
+    pthread_mutex_lock(&vars_lock);
+    struct shim_var *var = var_find(obj, name);
+    for (unsigned i = 0; var && i < var->callback_count; i ++) {
+        if (var->callbacks[i].cb == cb && var->callbacks[i].data == data) {
+            var->callbacks[i] = var->callbacks[--var->callback_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&vars_lock);
+}
+
+int shim_var_Type(vlc_object_t *obj, const char *name)
+{
+    pthread_mutex_lock(&vars_lock);
+    struct shim_var *var = var_find(obj, name);
+    const int type = var ? var->type : 0;
+    pthread_mutex_unlock(&vars_lock);
+    return type;
+}
+
+int shim_var_Get(vlc_object_t *obj, const char *name, int type, vlc_value_t *val)
+{
+    pthread_mutex_lock(&vars_lock);
+    struct shim_var *var = var_find(obj, name);
+    if (!var || var->type != (type & VLC_VAR_CLASS)) {
+        pthread_mutex_unlock(&vars_lock);
+        return VLC_EGENERIC;
+    }
+    value_copy(var->type, val, var->val);
+    pthread_mutex_unlock(&vars_lock);
+
+    return VLC_SUCCESS;
+}
+
+// the callbacks are called outside of the lock, like VLC does. A type of 0
+// sets the variable whatever its type, like var_Set() does
+int shim_var_Set(vlc_object_t *obj, const char *name, int type, vlc_value_t val)
+{
+    pthread_mutex_lock(&vars_lock);
+    struct shim_var *var = var_find(obj, name);
+    if (!var || (type && var->type != (type & VLC_VAR_CLASS))) {
+        pthread_mutex_unlock(&vars_lock);
+        return VLC_EGENERIC;
+    }
+    const vlc_value_t oldval = var->val;
+    value_copy(var->type, &var->val, val);
+    const unsigned count = var->callback_count;
+    vlc_callback_t cbs[CALLBACKS_MAX];
+    void *datas[CALLBACKS_MAX];
+    for (unsigned i = 0; i < count; i ++) {
+        cbs[i] = var->callbacks[i].cb;
+        datas[i] = var->callbacks[i].data;
+    }
+    pthread_mutex_unlock(&vars_lock);
+
+    for (unsigned i = 0; i < count; i ++) {
+        cbs[i](obj, name, oldval, val, datas[i]);
+    }
+    if ((type & VLC_VAR_CLASS) == VLC_VAR_STRING) {
+        free(oldval.psz_string);
+    }
+
+    return VLC_SUCCESS;
+}
+
+// config
+
+#define CONFIG_MAX 64
+
+static struct {
+    char name[64];
+    int type;
+    int64_t value;
+    char *psz_value;
+} config[CONFIG_MAX];
+static size_t config_count = 0;
+static pthread_mutex_t config_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// must be called with config_lock locked
+static size_t config_find(const char *name)
+{
+    size_t i = 0;
+    while (i < config_count && strcmp(config[i].name, name) != 0) {
+        i ++;
+    }
+    return i;
+}
+
+void shim_config_add(const char *name, int type, int64_t value, const char *psz_value)
+{
+    pthread_mutex_lock(&config_lock);
+    const size_t i = config_find(name);
+    if (i == CONFIG_MAX) {
+        pthread_mutex_unlock(&config_lock);
+        abort();
+    }
+    if (i == config_count) {
+        snprintf(config[i].name, sizeof(config[i].name), "%s", name);
+        config[i].psz_value = NULL;
+        config_count ++;
+    }
+    config[i].type = type;
+    config[i].value = value;
+    free(config[i].psz_value);
+    config[i].psz_value = psz_value ? strdup(psz_value) : NULL;
+    pthread_mutex_unlock(&config_lock);
+}
+
+int64_t config_GetInt(const char *name)
+{
+    pthread_mutex_lock(&config_lock);
+    const size_t i = config_find(name);
+    const int64_t value = i < config_count ? config[i].value : -1;
+    pthread_mutex_unlock(&config_lock);
+    return value;
+}
+
+void config_PutInt(const char *name, int64_t value)
+{
+    pthread_mutex_lock(&config_lock);
+    const size_t i = config_find(name);
+    if (i < config_count) {
+        config[i].value = value;
+    }
+    pthread_mutex_unlock(&config_lock);
+}
+
+char *config_GetPsz(const char *name)
+{
+    pthread_mutex_lock(&config_lock);
+    const size_t i = config_find(name);
+    char *psz_value = i < config_count && config[i].psz_value ? strdup(config[i].psz_value) : NULL;
+    pthread_mutex_unlock(&config_lock);
+    return psz_value;
+}
+
+void config_PutPsz(const char *name, const char *value)
+{
+    pthread_mutex_lock(&config_lock);
+    const size_t i = config_find(name);
+    if (i < config_count) {
+        free(config[i].psz_value);
+        config[i].psz_value = value ? strdup(value) : NULL;
+    }
+    pthread_mutex_unlock(&config_lock);
+}
+
+// the objects up the chain, then the config
+int shim_var_Inherit(vlc_object_t *obj, const char *name, int type, vlc_value_t *val)
+{
+    type &= VLC_VAR_CLASS;
+    for (; obj; obj = obj->parent) {
+        if (shim_var_Get(obj, name, type, val) == VLC_SUCCESS) {
+            return VLC_SUCCESS;
+        }
+    }
+
+    pthread_mutex_lock(&config_lock);
+    const size_t i = config_find(name);
+    if (i == config_count) {
+        pthread_mutex_unlock(&config_lock);
+        return VLC_EGENERIC;
+    }
+    switch (type) {
+        case VLC_VAR_BOOL:
+            val->b_bool = config[i].value != 0;
+            break;
+        case VLC_VAR_INTEGER:
+            val->i_int = config[i].value;
+            break;
+        case VLC_VAR_STRING:
+            val->psz_string = config[i].psz_value ? strdup(config[i].psz_value) : NULL;
+            break;
+        default:
+            pthread_mutex_unlock(&config_lock);
+            return VLC_EGENERIC;
+    }
+    pthread_mutex_unlock(&config_lock);
+
+    return VLC_SUCCESS;
+}
+
+void shim_msg(vlc_object_t *obj, int type, const char *format, ...)
+{
+    (void) obj;
+    (void) type;
+
+    // formatted like VLC would, without the allocations of its logger
+    char buf[512];
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+}
+
+// the player
+
+#define LISTENERS_MAX 4
+#define VOUTS_MAX 8
+
+struct vlc_player_listener_id {
+    const struct vlc_player_cbs *cbs;
+    void *data;
+};
+
+struct vlc_player_t {
+    pthread_mutex_t lock;
+    enum vlc_player_state state;
+    float rate;
+    struct vlc_player_listener_id listeners[LISTENERS_MAX];
+    bool listening[LISTENERS_MAX];
+    vout_thread_t *vouts[VOUTS_MAX];
+    size_t vout_count;
+    atomic_uint controls;
+};
+
+struct vlc_playlist {
+    vlc_player_t *player;
+};
+
+static vlc_player_t player = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .state = VLC_PLAYER_STATE_PLAYING,
+    .rate = 1.f,
+};
+static vlc_playlist_t playlist = {&player};
+
+vlc_playlist_t *vlc_intf_GetMainPlaylist(intf_thread_t *intf)
+{
+    (void) intf;
+    return &playlist;
+}
+
+vlc_player_t *vlc_playlist_GetPlayer(vlc_playlist_t *p_playlist)
+{
+    return p_playlist->player;
+}
+
+void vlc_player_Lock(vlc_player_t *p_player)
+{
+    pthread_mutex_lock(&p_player->lock);
+}
+
+void vlc_player_Unlock(vlc_player_t *p_player)
+{
+    pthread_mutex_unlock(&p_player->lock);
+}
+
+vlc_player_listener_id *vlc_player_AddListener(vlc_player_t *p_player,
+                                               const struct vlc_player_cbs *cbs, void *data)
+{
+    for (size_t i = 0; i < LISTENERS_MAX; i ++) {
+        if (!p_player->listening[i]) {
+            p_player->listening[i] = true;
+            p_player->listeners[i].cbs = cbs;
+            p_player->listeners[i].data = data;
+            return &p_player->listeners[i];
+        }
+    }
+    return NULL;
+}
+
+void vlc_player_RemoveListener(vlc_player_t *p_player, vlc_player_listener_id *id)
+{
+    p_player->listening[id - p_player->listeners] = false;
+}
+
+// must be called with the player locked, like VLC does
+static void state_change(vlc_player_t *p_player, enum vlc_player_state state)
+{
+    atomic_fetch_add(&p_player->controls, 1);
+    if (p_player->state == state) {
+        return;
+    }
+    p_player->state = state;
+    for (size_t i = 0; i < LISTENERS_MAX; i ++) {
+        if (p_player->listening[i] && p_player->listeners[i].cbs->on_state_changed) {
+            p_player->listeners[i].cbs->on_state_changed(p_player, state,
+                                                         p_player->listeners[i].data);
+        }
+    }
+}
+
+enum vlc_player_state vlc_player_GetState(vlc_player_t *p_player)
+{
+    return p_player->state;
+}
+
+const struct vlc_player_title *vlc_player_GetSelectedTitle(vlc_player_t *p_player)
+{
+    (void) p_player;
+    return NULL;
+}
+
+// the media plays along with the shim's clock
+vlc_tick_t vlc_player_GetTime(vlc_player_t *p_player)
+{
+    (void) p_player;
+    return vlc_tick_now();
+}
+
+float vlc_player_GetRate(vlc_player_t *p_player)
+{
+    return p_player->rate;
+}
+
+void vlc_player_ChangeRate(vlc_player_t *p_player, float rate)
+{
+    atomic_fetch_add(&p_player->controls, 1);
+    p_player->rate = rate;
+}
+
+void vlc_player_Pause(vlc_player_t *p_player)
+{
+    state_change(p_player, VLC_PLAYER_STATE_PAUSED);
+}
+
+void vlc_player_Resume(vlc_player_t *p_player)
+{
+    state_change(p_player, VLC_PLAYER_STATE_PLAYING);
+}
+
+void vlc_player_SeekByTime(vlc_player_t *p_player, vlc_tick_t time,
+                           enum vlc_player_seek_speed speed, enum vlc_player_whence whence)
+{
+    (void) time;
+    (void) speed;
+    (void) whence;
+    atomic_fetch_add(&p_player->controls, 1);
+}
+
+// the audio output doesn't take the player lock
+int vlc_player_aout_IncrementVolume(vlc_player_t *p_player, int steps, float *result)
+{
+    (void) steps;
+    atomic_fetch_add(&p_player->controls, 1);
+    if (result) {
+        *result = 1.f;
+    }
+    return VLC_SUCCESS;
+}
+
+vout_thread_t **vlc_player_vout_HoldAll(vlc_player_t *p_player, size_t *count)
+{
+    *count = p_player->vout_count;
+    if (!p_player->vout_count) {
+        return NULL;
+    }
+    vout_thread_t **pp_vout = malloc(p_player->vout_count * sizeof(*pp_vout));
+    if (!pp_vout) {
+        *count = 0;
+        return NULL;
+    }
+    memcpy(pp_vout, p_player->vouts, p_player->vout_count * sizeof(*pp_vout));
+    return pp_vout;
+}
+
+static void vout_change(vlc_player_t *p_player, enum vlc_player_vout_action action,
+                        vout_thread_t *vout)
+{
+    for (size_t i = 0; i < LISTENERS_MAX; i ++) {
+        if (p_player->listening[i] && p_player->listeners[i].cbs->on_vout_changed) {
+            p_player->listeners[i].cbs->on_vout_changed(p_player, action, vout,
+                                                        VLC_VOUT_ORDER_PRIMARY, NULL,
+                                                        p_player->listeners[i].data);
+        }
+    }
+}
+
+void shim_player_reset(void)
+{
+    vlc_player_Lock(&player);
+    player.state = VLC_PLAYER_STATE_PLAYING;
+    player.rate = 1.f;
+    atomic_store(&player.controls, 0);
+    vlc_player_Unlock(&player);
+}
+
+void shim_player_add_vout(vout_thread_t *vout)
+{
+    vlc_player_Lock(&player);
+    if (player.vout_count < VOUTS_MAX) {
+        player.vouts[player.vout_count ++] = vout;
+        vout_change(&player, VLC_PLAYER_VOUT_STARTED, vout);
+    }
+    vlc_player_Unlock(&player);
+}
+
+void shim_player_remove_vout(vout_thread_t *vout)
+{
+    vlc_player_Lock(&player);
+    for (size_t i = 0; i < player.vout_count; i ++) {
+        if (player.vouts[i] == vout) {
+            player.vouts[i] = player.vouts[-- player.vout_count];
+            vout_change(&player, VLC_PLAYER_VOUT_STOPPED, vout);
+            break;
+        }
+    }
+    vlc_player_Unlock(&player);
+}
+
+unsigned shim_player_controls(void)
+{
+    return atomic_load(&player.controls);
+}